@@ -1,155 +1,312 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "rayanim.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <float.h>
+#ifdef __APPLE__
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+#include <limits.h>
 #include <math.h>
+#include <poll.h>
 #include <raylib.h>
+#include <raymath.h>
+#include <rlgl.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+#define BATCH_CHUNK_VERTICES 3000
+
+RATexture textures[MAX_LOADED_ASSETS];
+unsigned char textureCount = 0;
+
+Font fonts[MAX_LOADED_ASSETS];
+bool sdfFonts[MAX_LOADED_ASSETS];
+unsigned char fontCount = 0;
 
 static int objectId = 0;
 static int animationId = 0;
 
-void initRAObjects(RAObjects *objects) {
-  objects->count = 0;
-  objects->capacity = DA_INIT_SIZE;
-  objects->objects = malloc(DA_INIT_SIZE * sizeof(RAObject *));
-  assert(objects->objects != NULL);
-}
+// Proxy textures are loaded at proxyScale; renderScale is the scale of the target being drawn.
+static float proxyScale = 1.0f;
+static const char *proxyCacheDir = NULL;
+static float renderScale = 1.0f;
 
-void pushToRAObjects(RAObjects *objects, RAObject *newObj) {
-  assert(objects != NULL);
+DEFINE_VECTOR(RAObjects, RAObject *, objects, MEMORY_SCENE)
+DEFINE_VECTOR(TemplateParams, TemplateParam, params, MEMORY_SCENE)
+DEFINE_VECTOR(TemplateOverrides, TemplateOverride, overrides, MEMORY_SCENE)
+DEFINE_VECTOR(TemplateObjectStates, TemplateObjectState, states, MEMORY_SCENE)
 
-  if (objects->count == objects->capacity) {
-    objects->capacity *= 2;
-    assert(realloc(objects->objects, objects->capacity * sizeof(RAObject *)) != NULL);
-  }
+int findIndexFromRAObjects(RAObjects *objects, RAObject *obj) {
+  for (int i = 0; i < objects->count; i++)
+    if (objects->objects[i]->_id == obj->_id) return i;
 
-  objects->objects[objects->count] = newObj;
-  objects->count++;
+  return -1;
 }
 
-RAObject *popFromRAObjects(RAObjects *objects) {
-  assert(objects != NULL);
+DEFINE_DEQUE(Animations, Animation *, MEMORY_SCENE)
 
-  if (objects->count == 0) return NULL;
+bool containsInAnimations(Animations *anims, Animation *anim) {
+  for (int i = 0; i < anims->count; i++)
+    if (getFromAnimations(anims, i)->_id == anim->_id) return true;
 
-  return objects->objects[--objects->count];
+  return false;
 }
 
-RAObject *getFromRAObjects(RAObjects *objects, int idx) {
-  assert(objects != NULL);
+DEFINE_SMALL_VECTOR(SpatialCell, int, SPATIAL_CELL_INLINE, MEMORY_SCENE)
+DEFINE_VECTOR(SpatialEntries, SpatialEntry, entries, MEMORY_SCENE)
+DEFINE_VECTOR(SpatialSlots, int, slots, MEMORY_SCENE)
+
+void initRAObject(RAObject *obj, Vector2 position, Color color, void (*render)(void *)) {
+  obj->_id = ++objectId;
+  obj->position = position;
+  obj->render = render;
+  obj->hash = hashDefaultRAObject;
+  obj->bounds = boundsDefaultRAObject;
+  obj->color = color;
+  obj->opacity = 1.0f;
+  obj->parent = NULL;
+  obj->revision = 1;
+  obj->localRevision = 1;
+  obj->_index = NULL;
+  obj->_indexSlot = -1;
+}
 
-  if (objects->count <= idx) return NULL;
+void initEmptyRAObject(RAObject *obj) {
+  initRAObject(obj, (Vector2){0, 0}, (Color){0, 0, 0, 0}, renderEmptyRAObject);
+}
 
-  return objects->objects[idx];
+void renderEmptyRAObject(void *self) {
+  (void)self;
 }
 
-void setToRAObjects(RAObjects *objects, int idx, RAObject *newObj) {
-  assert(objects != NULL);
+RAHash hashBytes(RAHash hash, const void *data, size_t size) {
+  const unsigned char *bytes = (const unsigned char *)data;
 
-  if (objects->count <= idx) return;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
 
-  objects->objects[idx] = newObj;
+  return hash;
 }
 
-int findIndexFromRAObjects(RAObjects *objects, RAObject *obj) {
-  for (int i = 0; i < objects->count; i++)
-    if (objects->objects[i]->_id == obj->_id) return i;
+// Frames are hashed on the render thread only. An object that cannot describe its state clears
+// this for the frame being hashed.
+static bool frameCacheable = true;
 
-  return -1;
+static void markFrameUncacheable(void) {
+  frameCacheable = false;
+}
+
+// Render callbacks are identified by their offset from a library symbol, which is stable across
+// runs of one build. A renderer rebuilt at the same offset is not noticed, so any change to what
+// a renderer draws has to bump FRAME_CACHE_VERSION.
+RAHash hashRAObjectBase(RAObject *obj, RAHash hash) {
+  intptr_t renderOffset = (intptr_t)obj->render - (intptr_t)renderEmptyRAObject;
+
+  hash = hashBytes(hash, &renderOffset, sizeof(renderOffset));
+  hash = hashBytes(hash, &obj->position, sizeof(obj->position));
+  hash = hashBytes(hash, &obj->color, sizeof(obj->color));
+  hash = hashBytes(hash, &obj->opacity, sizeof(obj->opacity));
+
+  return hash;
+}
+
+// Installed by initRAObject(). The object's own state is unknown here, so a frame that contains
+// it is never served from the frame cache.
+RAHash hashDefaultRAObject(void *self, RAHash hash) {
+  markFrameUncacheable();
+  return hashRAObjectBase((RAObject *)self, hash);
 }
 
-void destroyRAObjects(RAObjects *objects) {
-  free(objects->objects);
+// Objects that cannot describe their extent are never culled.
+Rectangle boundsDefaultRAObject(void *self) {
+  (void)self;
+  return (Rectangle){-FLT_MAX / 2, -FLT_MAX / 2, FLT_MAX, FLT_MAX};
 }
 
-void initAnimations(Animations *anims) {
-  anims->count = 0;
-  anims->capacity = DA_INIT_SIZE;
-  anims->animations = malloc(DA_INIT_SIZE * sizeof(Animation *));
-  assert(anims->animations != NULL);
+bool isBoundsUnbounded(Rectangle bounds) {
+  return (bounds.width >= FLT_MAX) || (bounds.height >= FLT_MAX);
 }
 
-void pushToAnimations(Animations *anims, Animation *newAnim) {
-  assert(anims != NULL);
+static void queueSpatialEntry(SpatialIndex *index, int slot);
+
+// Geometry changes bump the revision of the object and every group above it, since a group's
+// bounds follow its children, but only the object's own transform is invalidated. The root is
+// queued for refiling in the scene's spatial index, which is never refreshed otherwise. Anything
+// that writes position or size directly must call this.
+void markRAObjectDirty(RAObject *obj) {
+  RAObject *root = obj;
+  obj->localRevision++;
 
-  if (anims->count == anims->capacity) {
-    anims->capacity *= 2;
-    assert(realloc(anims->animations, anims->capacity * sizeof(Animation *)) != NULL);
+  for (RAObject *each = obj; each != NULL; each = each->parent) {
+    each->revision++;
+    root = each;
   }
 
-  anims->animations[anims->count] = newAnim;
-  anims->count++;
+  if (root->_index != NULL) queueSpatialEntry(root->_index, root->_indexSlot);
+}
+
+RAObject *getRootRAObject(RAObject *obj) {
+  while (obj->parent != NULL) obj = obj->parent;
+
+  return obj;
 }
 
-Animation *popFromAnimations(Animations *anims) {
-  assert(anims != NULL);
+Vector2 getRAObjectWorldPosition(RAObject *obj) {
+  if (obj->parent == NULL) return obj->position;
 
-  if (anims->count == 0) return NULL;
+  RAGroup *parent = (RAGroup *)obj->parent;
+  updateGroupTransform(parent);
 
-  return anims->animations[--anims->count];
+  return Vector2Transform(obj->position, parent->worldTransform);
 }
 
-Animation *popFirstFromAnimations(Animations *anims) {
-  assert(anims != NULL);
+float getRAObjectOpacity(RAObject *obj) {
+  float opacity = 1.0f;
+
+  for (RAObject *each = obj; each != NULL; each = each->parent) opacity *= each->opacity;
 
-  if (anims->count == 0) return NULL;
+  return fmaxf(fminf(opacity, 1.0f), 0.0f);
+}
 
-  Animation *firstAnim = anims->animations[0];
+Color premultiplyColor(Color color, float opacity) {
+  float alpha = (color.a / 255.0f) * opacity;
 
-  for (int i = 1; i < anims->count; i++) anims->animations[i - 1] = anims->animations[i];
+  return (Color){(unsigned char)(color.r * alpha + 0.5f),
+                 (unsigned char)(color.g * alpha + 0.5f),
+                 (unsigned char)(color.b * alpha + 0.5f),
+                 (unsigned char)(255.0f * alpha + 0.5f)};
+}
 
-  anims->count--;
+// Every color handed to raylib goes through here; the scene draws with premultiplied blending.
+Color resolveRAObjectColor(RAObject *obj, Color color) {
+  return premultiplyColor(color, getRAObjectOpacity(obj));
+}
 
-  return firstAnim;
+static int64_t getTextureMemory(Texture texture) {
+  return GetPixelDataSize(texture.width, texture.height, texture.format);
 }
 
-Animation *getFromAnimations(Animations *anims, int idx) {
-  assert(anims != NULL);
+static int64_t getFontMemory(Font font) {
+  int64_t size = getTextureMemory(font.texture);
+
+  for (int i = 0; i < font.glyphCount; i++) {
+    Image image = font.glyphs[i].image;
+    size += sizeof(GlyphInfo) + sizeof(Rectangle) +
+            GetPixelDataSize(image.width, image.height, image.format);
+  }
 
-  if (anims->count <= idx) return NULL;
+  return size;
+}
 
-  return anims->animations[idx];
+static void trackFont(Font font) {
+  trackMemory(MEMORY_FONTS, getFontMemory(font));
 }
 
-void setToAnimations(Animations *anims, int idx, Animation *newAnim) {
-  assert(anims != NULL);
+// Assets loaded from files are shared by every object that names the same file, and stay loaded
+// until unloadAssets(), so a process that renders many scenes decodes each file only once.
+static char textureFilenames[MAX_LOADED_ASSETS][256];
+static char fontFilenames[MAX_LOADED_ASSETS][256];
 
-  if (anims->count <= idx) return;
+// Frame hashes name assets by these instead of their index, which depends on load order. An
+// identity of 0 marks an asset that did not come from a file and cannot be cached.
+static RAHash textureIdentities[MAX_LOADED_ASSETS];
+static RAHash fontIdentities[MAX_LOADED_ASSETS];
 
-  anims->animations[idx] = newAnim;
+static RAHash getAssetIdentity(const char *filename, const void *key, size_t keySize) {
+  long modTime = GetFileModTime(filename);
+  RAHash hash = hashBytes(FNV_OFFSET_BASIS, filename, strlen(filename));
+  hash = hashBytes(hash, &modTime, sizeof(modTime));
+
+  return hashBytes(hash, key, keySize);
 }
 
-bool containsInAnimations(Animations *anims, Animation *anim) {
-  for (int i = 0; i < anims->count; i++)
-    if (anims->animations[i]->_id == anim->_id) return true;
+// Loaded assets are matched by identity as well as by name, so a file that changed on disk since
+// it was loaded is loaded again.
+static int findLoadedTexture(const char *filename, RAHash identity) {
+  for (int i = 0; i < textureCount; i++)
+    if ((textureIdentities[i] == identity) && (strcmp(textureFilenames[i], filename) == 0))
+      return i;
 
-  return false;
+  return -1;
 }
 
-void destroyAnimations(Animations *anims) {
-  free(anims->animations);
+static int findLoadedFont(const char *filename, RAHash identity) {
+  for (int i = 1; i < fontCount; i++)
+    if ((fontIdentities[i] == identity) && (strcmp(fontFilenames[i], filename) == 0)) return i;
+
+  return -1;
 }
 
-void initRAObject(RAObject *obj, Vector2 position, Color color, void (*render)(void *)) {
-  obj->_id = ++objectId;
-  obj->position = position;
-  obj->render = render;
-  obj->color = color;
+// Once every font slot is taken, texts fall back to the default font.
+static bool hasFreeFontSlot(const char *filename) {
+  if (fontCount < MAX_LOADED_ASSETS) return true;
+
+  TraceLog(LOG_WARNING, "RayAnim: Too many fonts to load %s", filename);
+  return false;
 }
 
-void initEmptyRAObject(RAObject *obj) {
-  initRAObject(obj, (Vector2){0, 0}, (Color){0, 0, 0, 0}, renderEmptyRAObject);
+// Names that do not fit are left empty, which only means the asset is never shared.
+static void setAssetFilename(char name[256], const char *filename) {
+  if ((filename == NULL) || (strlen(filename) >= 256)) {
+    name[0] = '\0';
+    return;
+  }
+
+  strcpy(name, filename);
 }
 
-void renderEmptyRAObject(void *self) {
-  (void)self;
+static void unloadSdfShader(void);
+
+// Textures and fonts outlive the objects that use them, so they are unloaded with the scene,
+// while the GL context still exists. The default font belongs to raylib.
+static void unloadAssets(void) {
+  for (int i = 0; i < textureCount; i++) {
+    for (int level = 0; level < textures[i].levelCount; level++) {
+      trackMemory(MEMORY_TEXTURES, -getTextureMemory(textures[i].levels[level]));
+      UnloadTexture(textures[i].levels[level]);
+    }
+  }
+
+  for (int i = 1; i < fontCount; i++) {
+    trackMemory(MEMORY_FONTS, -getFontMemory(fonts[i]));
+    UnloadFont(fonts[i]);
+    sdfFonts[i] = false;
+  }
+
+  unloadSdfShader();
+
+  textureCount = 0;
+  fontCount = fontCount > 0 ? 1 : 0;
+}
+
+static void premultiplyTexture(Texture texture) {
+  Image image = LoadImageFromTexture(texture);
+  ImageAlphaPremultiply(&image);
+  UpdateTexture(texture, image.data);
+  UnloadImage(image);
 }
 
 void initAnimation(Animation *anim,
                    RAObject *obj,
                    float duration,
-                   bool (*update)(void *, float),
+                   bool (*update)(void *, double),
                    void (*interpolate)(void *, float),
                    void (*pushToObjects)(Scene *)) {
   anim->_id = ++animationId;
@@ -160,6 +317,13 @@ void initAnimation(Animation *anim,
   anim->update = update;
   anim->interpolate = interpolate;
   anim->pushToObjects = pushToObjects;
+  anim->reset = NULL;
+}
+
+static void startAnimation(Animation *anim) {
+  anim->elapsedTime = 0.0;
+  anim->done = false;
+  if (anim->reset != NULL) anim->reset(anim);
 }
 
 void initDefaultAnimation(Animation *anim,
@@ -170,13 +334,13 @@ void initDefaultAnimation(Animation *anim,
       anim, obj, duration, updateDefaultAnimation, interpolate, pushToObjectsDefaultAnimation);
 }
 
-bool updateDefaultAnimation(void *self, float dt) {
+bool updateDefaultAnimation(void *self, double time) {
   Animation *anim = (Animation *)self;
 
   if (anim->done) return true;
 
-  anim->elapsedTime += dt;
-  anim->interpolate(anim, fminf(anim->elapsedTime / anim->duration, 1.0f));
+  anim->elapsedTime = time;
+  anim->interpolate(anim, fminf((float)(anim->elapsedTime / anim->duration), 1.0f));
 
   bool completed = anim->elapsedTime >= anim->duration;
   if (completed) anim->done = true;
@@ -184,39 +348,102 @@ bool updateDefaultAnimation(void *self, float dt) {
   return completed;
 }
 
-void pushToObjectsDefaultAnimation(Scene *scene) {
-  RAObject *currentObj = scene->currentAnimation->object;
-  int idx = findIndexFromRAObjects(&scene->objects, currentObj);
+static void showRAObjectInScene(Scene *scene, RAObject *obj) {
+  // Grouped objects are drawn by their group, so the scene only holds the root. Empty objects
+  // draw nothing, and the one delays share cannot be filed in several scenes' indexes.
+  RAObject *root = getRootRAObject(obj);
+  if (root->render == renderEmptyRAObject) return;
+
+  int idx = findIndexFromRAObjects(&scene->objects, root);
 
   if (idx == -1) {
-    pushToRAObjects(&scene->objects, currentObj);
+    addToScene(scene, root);
   } else {
-    setToRAObjects(&scene->objects, idx, currentObj);
+    setToRAObjects(&scene->objects, idx, root);
   }
+}
+
+void pushToObjectsDefaultAnimation(Scene *scene) {
+  showRAObjectInScene(scene, scene->currentAnimation->object);
 
   TraceLog(LOG_INFO, "RayAnim: Started Animation #%i", scene->currentAnimation->_id);
 }
 
 void initScene(Scene *scene, const char *title, int width, int height, Color color) {
   scene->currentAnimation = NULL;
+  scene->animationStartTime = 0.0;
+  scene->timingMode = TIMING_REALTIME;
+  scene->fps = 60;
+  scene->frame = 0;
+  scene->time = 0.0;
   scene->color = color;
   scene->width = width;
   scene->height = height;
   scene->title = title;
-
-  fonts[0] = GetFontDefault();
-  fontCount = 1;
+  scene->retireFadedObjects = false;
+  scene->outputDir = "frames";
+  scene->cacheDir = NULL;
+  scene->frameRing = NULL;
+  scene->frameSequence = NULL;
+  scene->renditionCount = 0;
+  scene->compiled = false;
+  scene->plan = (ScenePlan){0};
+  scene->showMemoryStats = false;
 
   initRAObjects(&scene->objects);
+  initDisplayList(&scene->displayList, width, height);
   initAnimations(&scene->animations);
+  initSpatialIndex(&scene->spatialIndex, width, height, SPATIAL_CELL_SIZE);
+
+  // A render server keeps one window, and the assets loaded in it, for all of its scenes.
+  if (IsWindowReady()) return;
 
   InitWindow(scene->width, scene->height, scene->title);
+
+  fonts[0] = GetFontDefault();
+  fontIdentities[0] = hashBytes(FNV_OFFSET_BASIS, "default", 7);
+  fontCount = 1;
+  premultiplyTexture(fonts[0].texture);
 }
 
 void initDefaultScene(Scene *scene, const char *title) {
   initScene(scene, title, 2400, 1600, RAYWHITE);
 }
 
+void initHeadlessScene(Scene *scene, const char *title, int width, int height, Color color) {
+  SetConfigFlags(FLAG_WINDOW_HIDDEN);
+  initScene(scene, title, width, height, color);
+  setSceneTimingMode(scene, TIMING_FIXED_STEP, scene->fps);
+}
+
+void addToScene(Scene *scene, RAObject *obj) {
+  assert(obj->parent == NULL);
+
+  pushToRAObjects(&scene->objects, obj);
+  insertIntoSpatialIndex(&scene->spatialIndex, obj);
+}
+
+RAObject *hitTestScene(Scene *scene, Vector2 point) {
+  updateSpatialIndex(&scene->spatialIndex);
+
+  RAObject **candidates;
+  Rectangle area = {point.x, point.y, 0, 0};
+  int count = querySpatialIndex(&scene->spatialIndex, area, &candidates);
+
+  for (int i = count - 1; i >= 0; i--) {
+    RAObject *obj = candidates[i];
+    Rectangle bounds = obj->bounds(obj);
+
+    if (isBoundsUnbounded(bounds) || (getRAObjectOpacity(obj) <= 0.0f)) continue;
+
+    if ((point.x >= bounds.x) && (point.x <= bounds.x + bounds.width) && (point.y >= bounds.y) &&
+        (point.y <= bounds.y + bounds.height))
+      return obj;
+  }
+
+  return NULL;
+}
+
 void playAnimation(Scene *scene, Animation *anim) {
   assert((scene != NULL) && (anim != NULL));
 
@@ -227,687 +454,5793 @@ void playAnimations(Scene *scene, Animation **anims, int animCount) {
   for (int i = 0; i < animCount; i++) playAnimation(scene, anims[i]);
 }
 
-void renderScene(Scene *scene) {
-  BeginDrawing();
+bool isRAObjectVisible(Scene *scene, RAObject *obj) {
+  if (getRAObjectOpacity(obj) <= 0.0f) return false;
+
+  Rectangle bounds = obj->bounds(obj);
+  if (isBoundsUnbounded(bounds)) return true;
+
+  return (bounds.x < scene->width) && (bounds.y < scene->height) &&
+         (bounds.x + bounds.width > 0) && (bounds.y + bounds.height > 0);
+}
+
+// Fully faded objects are never removed by their animations, so long scenes can drop them
+// once nothing is animating them. An animation that shows them again pushes them back on top.
+void retireFadedObjects(Scene *scene) {
+  int kept = 0;
 
-  ClearBackground(scene->color);
   for (int i = 0; i < scene->objects.count; i++) {
-    RAObject *obj = getFromRAObjects(&scene->objects, i);
-    if (obj != NULL) obj->render(obj);
+    RAObject *obj = scene->objects.objects[i];
+
+    if (obj->opacity > 0.0f) {
+      scene->objects.objects[kept++] = obj;
+    } else {
+      removeFromSpatialIndex(&scene->spatialIndex, obj);
+    }
   }
 
-  EndDrawing();
+  scene->objects.count = kept;
 }
 
-void updateScene(Scene *scene, float dt) {
-  if ((scene->currentAnimation == NULL) && (scene->animations.count > 0)) {
-    scene->currentAnimation = popFirstFromAnimations(&scene->animations);
-    scene->currentAnimation->elapsedTime = 0.0f;
-    scene->currentAnimation->done = false;
-    scene->currentAnimation->pushToObjects(scene);
-    // RAObject *currentObj = scene->currentAnimation->object;
-    // TraceLog(LOG_INFO, "RayAnim: Started Animation #%i", scene->currentAnimation->_id);
-    // // if (!containsInRAObjects(&scene->objects, currentObj))
-    // pushToRAObjects(&scene->objects, currentObj);
-  }
-
-  if ((scene->currentAnimation != NULL) &&
-      (scene->currentAnimation->update(scene->currentAnimation, dt))) {
-    TraceLog(LOG_INFO, "RayAnim: Finished Animation #%i", scene->currentAnimation->_id);
-    scene->currentAnimation = NULL;
-  }
+static Rectangle getSceneViewport(Scene *scene) {
+  return (Rectangle){0, 0, scene->width, scene->height};
 }
 
-void destroyScene(Scene *scene) {
-  destroyRAObjects(&scene->objects);
-  destroyAnimations(&scene->animations);
-  scene = NULL;
+// Smaller areas, such as tiles, only visit the cells they touch. The grid spans the viewport, so
+// a query covering all of it would visit every cell and sort; the object list, which is already
+// in draw order, is filtered against the bounds the index keeps instead.
+static int collectVisibleObjects(Scene *scene, Rectangle area, RAObject ***visible) {
+  SpatialIndex *index = &scene->spatialIndex;
+  updateSpatialIndex(index);
+
+  RAObject **candidates;
+  int count;
+  if ((area.x <= 0) && (area.y <= 0) && (area.x + area.width >= scene->width) &&
+      (area.y + area.height >= scene->height)) {
+    count =
+        filterSpatialIndex(index, scene->objects.objects, scene->objects.count, area, &candidates);
+  } else {
+    count = querySpatialIndex(index, area, &candidates);
+  }
+  int visibleCount = 0;
 
-  // for (int i = 0; i < textureCount; i++) UnloadTexture(textures[i]);
+  for (int i = 0; i < count; i++)
+    if (getRAObjectOpacity(candidates[i]) > 0.0f) candidates[visibleCount++] = candidates[i];
 
-  // for (int i = 0; i < fontCount; i++) UnloadFont(fonts[i]);
+  *visible = candidates;
+  return visibleCount;
 }
 
-void startScene(Scene *scene) {
-  SetTargetFPS(120);
-
-  float lastTime = GetTime();
+static void flushDisplayList(DisplayList *list);
 
-  while (!WindowShouldClose()) {
-    if (IsKeyPressed(KEY_Q)) break;
+// The frame is recorded into the scene's display list while it is drawn, so other sinks can
+// replay, hash or export it afterwards without evaluating the scene again.
+static void drawSceneObjects(Scene *scene, Rectangle area) {
+  RAObject **visible;
+  int visibleCount = collectVisibleObjects(scene, area, &visible);
 
-    float currentTime = GetTime();
-    float dt = currentTime - lastTime;
-    lastTime = currentTime;
+  ClearBackground(scene->color);
+  BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
 
-    updateScene(scene, dt);
-    renderScene(scene);
-  }
+  beginDisplayList(&scene->displayList, scene->color);
+  for (int i = 0; i < visibleCount; i++) renderRAObject(visible[i]);
+  endDisplayList();
+  flushDisplayList(&scene->displayList);
 
-  CloseWindow();
+  EndBlendMode();
 }
 
-void recordScene(Scene *scene) {
-  // TODO: will be implemented later
-  scene = scene;
+void renderScene(Scene *scene) {
+  BeginDrawing();
+  drawSceneObjects(scene, getSceneViewport(scene));
+  if (scene->showMemoryStats) drawMemoryStats(10, 10);
+  EndDrawing();
 }
 
-// ------------------------------ Built-In RAObjects & Animations ------------------------------
+void updateScene(Scene *scene, float dt) {
+  seekScene(scene, scene->time + dt);
+}
 
-// --------------- RACircle ---------------
+DEFINE_VECTOR(PlanSteps, PlanStep, steps, MEMORY_SCENE)
+DEFINE_VECTOR(PlanEntries, int, entries, MEMORY_SCENE)
 
-void initCircle(RACircle *RACircle,
-                Vector2 center,
-                float radius,
-                float outlineThickness,
-                int segments,
-                Color innerColor,
-                Color outlineColor,
-                void (*render)(void *)) {
-  initRAObject(&RACircle->base, center, innerColor, render);
-  RACircle->radius = radius;
-  RACircle->angle = 0.0f;
-  RACircle->outlineThickness = outlineThickness;
-  RACircle->segments = segments;
-  RACircle->outlineColor = outlineColor;
+static int pushPlanStep(ScenePlan *plan, Animation *anim, double start, int parent, bool driven) {
+  pushToPlanSteps(&plan->steps, (PlanStep){anim, start, start, parent, 0, driven, false});
+  return plan->steps.count - 1;
 }
 
-void initDefaultCircle(RACircle *RACircle, Vector2 center, float radius) {
-  initCircle(RACircle, center, radius, 25.0f, 100, BLUE, DARKBLUE, renderDefaultCircle);
+// Appends anim and everything it drives, returning the index of its step or -1 on a cycle. Sync
+// groups and moves are recognized by their update function, like batched renderers are; any
+// other animation is opaque and treated as a leaf. A sync's span, the end of its longest child,
+// is kept in its step; the animation itself is left as the caller built it.
+static int compilePlanStep(
+    ScenePlan *plan, Animation *anim, double start, int parent, bool driven) {
+  for (int i = parent; i != -1; i = plan->steps.steps[i].parent) {
+    if (plan->steps.steps[i].anim == anim) {
+      TraceLog(LOG_ERROR, "RayAnim: Animation #%i contains itself", anim->_id);
+      return -1;
+    }
+  }
+
+  bool isSync = anim->update == updateDefaultSyncAnimation;
+  bool isMove = anim->update == updateDefaultMoveAnimation;
+  int idx = pushPlanStep(plan, anim, start, parent, driven && !isSync);
+  double end = start + anim->duration;
+
+  if (isSync) {
+    SyncAnimation *sync = (SyncAnimation *)anim;
+    end = start;
+
+    for (int i = 0; i < sync->animCount; i++) {
+      int child = compilePlanStep(plan, sync->animations[i], start, idx, driven);
+      if (child == -1) return -1;
+      end = fmax(end, plan->steps.steps[child].end);
+    }
+  } else if (isMove) {
+    int child = compilePlanStep(plan, ((MoveAnimation *)anim)->targetAnim, start, idx, false);
+    if (child == -1) return -1;
+    end = fmax(end, plan->steps.steps[child].end);
+  }
+
+  plan->steps.steps[idx].end = end;
+  plan->steps.steps[idx].subtreeEnd = plan->steps.count;
+  return idx;
 }
 
-RACircle createCircle(Vector2 center, float radius) {
-  RACircle RACircle;
-  initDefaultCircle(&RACircle, center, radius);
-  return RACircle;
+static int comparePointers(const void *a, const void *b) {
+  uintptr_t left = (uintptr_t)((const PlanStep *)a)->anim;
+  uintptr_t right = (uintptr_t)((const PlanStep *)b)->anim;
+  return (left > right) - (left < right);
 }
 
-void renderDefaultCircle(void *self) {
-  RACircle *circle = (RACircle *)self;
-  circle->outlineColor.a = circle->base.color.a;
+// Counts animations that occur more than once in steps[start, end).
+static int countAliasedSteps(ScenePlan *plan, int start, int end) {
+  int count = end - start;
+  if (count < 2) return 0;
 
-  float innerRadius = circle->radius - circle->outlineThickness / 2;
-  float outerRadius = circle->radius + circle->outlineThickness / 2;
-  DrawRing(circle->base.position,
-           innerRadius,
-           outerRadius,
-           0.0f,
-           circle->angle,
-           circle->segments,
-           circle->outlineColor);
+  PlanStep *sorted = allocateMemory(MEMORY_SCENE, count * sizeof(PlanStep));
+  assert(sorted != NULL);
+  memcpy(sorted, plan->steps.steps + start, count * sizeof(PlanStep));
+  qsort(sorted, count, sizeof(PlanStep), comparePointers);
+
+  int aliased = 0;
+  for (int i = 1; i < count; i++)
+    if (sorted[i].anim == sorted[i - 1].anim) aliased++;
+
+  releaseMemory(sorted);
+  return aliased;
 }
 
-void renderFillInnerCircle(void *self) {
-  RACircle *circle = (RACircle *)self;
-  circle->outlineColor.a = circle->base.color.a;
+static bool areAnimationsIndependent(Animation **anims, int animCount);
 
-  float halfThickness = circle->outlineThickness / 2;
+// Checked when compiling, so objects regrouped afterwards must not start sharing a tree.
+static bool isPlanEntryIndependent(ScenePlan *plan, int entry) {
+  int count = plan->steps.steps[entry].subtreeEnd - entry;
+  Animation **driven = allocateMemory(MEMORY_SCENE, count * sizeof(Animation *));
+  assert(driven != NULL);
 
-  DrawCircleSector(circle->base.position,
-                   circle->radius + halfThickness,
-                   0.0f,
-                   circle->angle,
-                   circle->segments,
-                   circle->outlineColor);
+  int drivenCount = 0;
+  for (int i = entry; i < plan->steps.steps[entry].subtreeEnd; i++)
+    if (plan->steps.steps[i].driven) driven[drivenCount++] = plan->steps.steps[i].anim;
 
-  DrawCircleSector(circle->base.position,
-                   circle->radius - halfThickness,
-                   0.0f,
-                   circle->angle,
-                   circle->segments,
-                   circle->base.color);
+  bool independent = areAnimationsIndependent(driven, drivenCount);
+  releaseMemory(driven);
+  return independent;
 }
 
-void initCircleAnimation(Animation *anim,
-                         RACircle *RACircle,
-                         float duration,
-                         bool (*update)(void *, float),
-                         void (*interpolate)(void *, float)) {
-  initAnimation(
-      anim, (RAObject *)RACircle, duration, update, interpolate, pushToObjectsDefaultAnimation);
+static void destroyScenePlan(ScenePlan *plan) {
+  destroyPlanSteps(&plan->steps);
+  destroyPlanEntries(&plan->entries);
+  *plan = (ScenePlan){0};
 }
 
-void initDefaultCircleAnimation(Animation *anim, RACircle *RACircle) {
-  initCircleAnimation(
-      anim, RACircle, 0.8f, updateDefaultAnimation, interpolateDefaultCircleAnimation);
-}
+// Flattens the queued animations into a plan with absolute start and end times, then empties the
+// queue. An instance may be queued again later since its state is reset when its entry starts,
+// but it must not occur twice within one entry, where both uses would share that state.
+bool compileScene(Scene *scene) {
+  ScenePlan *plan = &scene->plan;
+  destroyScenePlan(plan);
+  scene->compiled = false;
+
+  double time = scene->time;
+
+  for (int i = 0; i < scene->animations.count; i++) {
+    Animation *anim = getFromAnimations(&scene->animations, i);
+    int idx = compilePlanStep(plan, anim, time, -1, true);
+
+    if ((idx == -1) || (countAliasedSteps(plan, idx, plan->steps.count) > 0)) {
+      if (idx != -1)
+        TraceLog(LOG_ERROR, "RayAnim: Animation #%i uses the same instance twice", anim->_id);
+      destroyScenePlan(plan);
+      return false;
+    }
 
-Animation createCircleAnimation(RACircle *RACircle) {
-  Animation anim;
-  initDefaultCircleAnimation(&anim, RACircle);
-  return anim;
-}
-void interpolateDefaultCircleAnimation(void *self, float time) {
-  Animation *anim = (Animation *)self;
-  RACircle *circle = (RACircle *)anim->object;
-  circle->angle = time * 360.0f;
+    pushToPlanEntries(&plan->entries, idx);
+    plan->steps.steps[idx].independent = isPlanEntryIndependent(plan, idx);
+    time = plan->steps.steps[idx].end;
+  }
+
+  plan->duration = time - scene->time;
+  clearAnimations(&scene->animations);
+  scene->compiled = true;
+
+  TraceLog(LOG_INFO,
+           "RayAnim: Compiled %i animations into %i steps (%.2f s, %i reused)",
+           plan->entries.count,
+           plan->steps.count,
+           plan->duration,
+           countAliasedSteps(plan, 0, plan->steps.count));
+  return true;
 }
 
-// --------------- RACircle ---------------
+typedef struct PlanChunkContext {
+  PlanStep *steps;
+  double time;
+  int first;
+  int *chunkPending;
+} PlanChunkContext;
 
-// ------------- RARectangle --------------
+static void updatePlanChunk(void *context, int start, int end) {
+  PlanChunkContext *chunk = (PlanChunkContext *)context;
+  int pending = 0;
 
-void initRectangle(RARectangle *rect,
-                   Vector2 position,
-                   float width,
-                   float height,
-                   float outlineThickness,
-                   Color innerColor,
-                   Color outlineColor,
-                   void (*render)(void *)) {
-  initRAObject(&rect->base, position, innerColor, render);
-  rect->width = width;
-  rect->height = height;
-  rect->outlineThickness = outlineThickness;
-  rect->outlineColor = outlineColor;
+  for (int i = chunk->first + start; i < chunk->first + end; i++) {
+    PlanStep *step = &chunk->steps[i];
+    if (step->driven && !step->anim->update(step->anim, chunk->time - step->start)) pending++;
+  }
 
-  rect->firstQuarter = 0.0f;
-  rect->secondQuarter = 0.0f;
-  rect->thirdQuarter = 0.0f;
-  rect->lastQuarter = 0.0f;
+  chunk->chunkPending[start / SYNC_PARALLEL_CHUNK] = pending;
 }
 
-void initDefaultRectangle(RARectangle *rect, Vector2 position, float width, float height) {
-  initRectangle(rect, position, width, height, 25.0f, GREEN, DARKGREEN, renderDefaultRectangle);
-}
+// Walks the compiled plan, starting and finishing as many entries as `time` covers. Starting an
+// entry shows the object of every step in it instead of calling pushToObjects. Returns false
+// once the plan is exhausted so any animations queued afterwards run as before.
+static bool seekScenePlan(Scene *scene) {
+  ScenePlan *plan = &scene->plan;
+
+  while (plan->currentEntry < plan->entries.count) {
+    PlanStep *entry = &plan->steps.steps[plan->entries.entries[plan->currentEntry]];
+    int first = plan->entries.entries[plan->currentEntry];
+    int count = entry->subtreeEnd - first;
+
+    if (scene->currentAnimation == NULL) {
+      for (int i = first; i < entry->subtreeEnd; i++) {
+        Animation *anim = plan->steps.steps[i].anim;
+        startAnimation(anim);
+        if (anim->object != NULL) showRAObjectInScene(scene, anim->object);
+      }
+
+      TraceLog(LOG_INFO, "RayAnim: Started Animation #%i", entry->anim->_id);
+      scene->currentAnimation = entry->anim;
+      scene->animationStartTime = entry->start;
+    }
 
-RARectangle createRectangle(Vector2 position, float width, float height) {
-  RARectangle rect;
-  initDefaultRectangle(&rect, position, width, height);
-  return rect;
-}
+    RAThreadPool *pool = getSharedThreadPool();
+    int chunkCount = (count + SYNC_PARALLEL_CHUNK - 1) / SYNC_PARALLEL_CHUNK;
+    int chunkPending[chunkCount];
+    PlanChunkContext context = {plan->steps.steps, scene->time, first, chunkPending};
 
-void renderDefaultRectangle(void *self) {
-  RARectangle *rect = (RARectangle *)self;
-  rect->outlineColor.a = rect->base.color.a;
+    if ((count >= SYNC_PARALLEL_THRESHOLD) && (pool->workerCount > 0) && entry->independent) {
+      parallelFor(pool, count, SYNC_PARALLEL_CHUNK, updatePlanChunk, &context);
+    } else {
+      for (int i = 0; i < chunkCount; i++) {
+        int end = (i + 1) * SYNC_PARALLEL_CHUNK;
+        updatePlanChunk(&context, i * SYNC_PARALLEL_CHUNK, end < count ? end : count);
+      }
+    }
 
-  float x = rect->base.position.x;
-  float y = rect->base.position.y;
-  float width = rect->width;
-  float height = rect->height;
-  float halfThickness = rect->outlineThickness / 2.0f;
-  float thickness = rect->outlineThickness;
-  float firstQuarter = rect->firstQuarter;
-  float secondQuarter = rect->secondQuarter;
-  float thirdQuarter = rect->thirdQuarter;
-  float lastQuarter = rect->lastQuarter;
+    for (int i = 0; i < chunkCount; i++)
+      if (chunkPending[i] > 0) return true;
 
-  DrawLineEx((Vector2){x, y + halfThickness},
-             (Vector2){x + (width - thickness) * firstQuarter, y + halfThickness},
-             thickness,
-             rect->outlineColor);
+    entry->anim->elapsedTime = scene->time - entry->start;
+    entry->anim->done = true;
 
-  DrawLineEx((Vector2){x + width - halfThickness, y},
-             (Vector2){x + width - halfThickness, y + (height - thickness) * secondQuarter},
-             thickness,
-             rect->outlineColor);
+    TraceLog(LOG_INFO, "RayAnim: Finished Animation #%i", entry->anim->_id);
+    scene->currentAnimation = NULL;
+    scene->animationStartTime = entry->end;
+    plan->currentEntry++;
 
-  DrawLineEx(
-      (Vector2){x + width, y + height - halfThickness},
-      (Vector2){(x + width) - (width - thickness) * thirdQuarter, y + height - halfThickness},
-      thickness,
-      rect->outlineColor);
+    if (scene->retireFadedObjects) retireFadedObjects(scene);
+  }
 
-  DrawLineEx((Vector2){x + halfThickness, y + height},
-             (Vector2){x + halfThickness, (y + height) - (height - thickness) * lastQuarter},
-             thickness,
-             rect->outlineColor);
+  return false;
+}
+
+// How long anim runs as compilePlanStep() lays it out: a sync lasts as long as its longest child
+// and a move as long as itself or its target, whichever is longer.
+static double getAnimationSpan(Animation *anim) {
+  double span = anim->duration;
+
+  if (anim->update == updateDefaultSyncAnimation) {
+    SyncAnimation *sync = (SyncAnimation *)anim;
+    span = 0.0;
+    for (int i = 0; i < sync->animCount; i++)
+      span = fmax(span, getAnimationSpan(sync->animations[i]));
+  } else if (anim->update == updateDefaultMoveAnimation) {
+    span = fmax(span, getAnimationSpan(((MoveAnimation *)anim)->targetAnim));
+  }
+
+  return span;
+}
+
+// Animations are evaluated from the scene's absolute time, never from accumulated deltas, so
+// the same sequence of seek times always yields the same frames. Queued animations start where
+// the previous one ended rather than at the frame that noticed it, and several may start and
+// finish within one seek, so playback matches a compiled plan. One queued while the scene was
+// idle starts at the previous seek.
+void seekScene(Scene *scene, double time) {
+  assert(time >= scene->time);
+  double previousTime = scene->time;
+  scene->time = time;
+
+  if (scene->compiled && seekScenePlan(scene)) return;
+
+  while (true) {
+    if (scene->currentAnimation == NULL) {
+      if (scene->animations.count == 0) return;
+
+      scene->currentAnimation = popFirstFromAnimations(&scene->animations);
+      scene->animationStartTime = fmax(scene->animationStartTime, previousTime);
+      startAnimation(scene->currentAnimation);
+      scene->currentAnimation->pushToObjects(scene);
+      // RAObject *currentObj = scene->currentAnimation->object;
+      // TraceLog(LOG_INFO, "RayAnim: Started Animation #%i", scene->currentAnimation->_id);
+      // // if (!containsInRAObjects(&scene->objects, currentObj))
+      // pushToRAObjects(&scene->objects, currentObj);
+    }
+
+    if (!scene->currentAnimation->update(scene->currentAnimation,
+                                         scene->time - scene->animationStartTime))
+      return;
+
+    TraceLog(LOG_INFO, "RayAnim: Finished Animation #%i", scene->currentAnimation->_id);
+    scene->animationStartTime += getAnimationSpan(scene->currentAnimation);
+    scene->currentAnimation = NULL;
+
+    if (scene->retireFadedObjects) retireFadedObjects(scene);
+  }
+}
+
+void stepScene(Scene *scene) {
+  assert(scene->fps > 0);
+
+  scene->frame++;
+  seekScene(scene, (double)scene->frame / scene->fps);
+}
+
+void setSceneTimingMode(Scene *scene, TimingMode mode, int fps) {
+  assert(fps > 0);
+
+  scene->timingMode = mode;
+  scene->fps = fps;
+}
+
+// A NULL outputDir disables writing frame files, e.g. when frames only go to a frame ring.
+void setSceneRecordOutput(Scene *scene, const char *outputDir, const char *cacheDir) {
+  assert((outputDir != NULL) || (cacheDir == NULL));
+
+  scene->outputDir = outputDir;
+  scene->cacheDir = cacheDir;
+}
+
+// Every frame shown by startScene() or produced by recordScene() is also published to the ring.
+void setSceneFrameRing(Scene *scene, RAFrameRing *ring) {
+  assert((ring == NULL) || ((ring->header->width == (uint32_t)scene->width) &&
+                            (ring->header->height == (uint32_t)scene->height)));
+
+  scene->frameRing = ring;
+}
+
+// Renditions are written to their own directories next to the regular output, which may be
+// disabled with a NULL outputDir when only the renditions are wanted.
+void addSceneRendition(
+    Scene *scene, int width, int height, int frameInterval, const char *outputDir) {
+  assert(scene->renditionCount < MAX_RENDITIONS);
+  assert((width > 0) && (width <= scene->width) && (height > 0) && (height <= scene->height));
+  assert((frameInterval > 0) && (outputDir != NULL));
+
+  scene->renditions[scene->renditionCount++] =
+      (RARendition){width, height, frameInterval, outputDir};
+}
+
+// Every frame produced by recordScene() is also appended to the sequence.
+void setSceneFrameSequence(Scene *scene, RAFrameSequence *sequence) {
+  assert((sequence == NULL) ||
+         (sequence->writing && (sequence->header.width == (uint32_t)scene->width) &&
+          (sequence->header.height == (uint32_t)scene->height)));
+
+  scene->frameSequence = sequence;
+}
+
+// Returns 0 for a frame that must not be cached.
+RAHash hashSceneFrame(Scene *scene) {
+  RAHash hash = FNV_OFFSET_BASIS;
+  uint32_t version = FRAME_CACHE_VERSION;
+  frameCacheable = true;
+
+  hash = hashBytes(hash, &version, sizeof(version));
+  hash = hashBytes(hash, &scene->width, sizeof(scene->width));
+  hash = hashBytes(hash, &scene->height, sizeof(scene->height));
+  hash = hashBytes(hash, &scene->color, sizeof(scene->color));
+  // Frames recorded with proxy textures must not be served for full-resolution ones.
+  hash = hashBytes(hash, &proxyScale, sizeof(proxyScale));
+
+  RAObject **visible;
+  int visibleCount = collectVisibleObjects(scene, getSceneViewport(scene), &visible);
+
+  for (int i = 0; i < visibleCount; i++) hash = visible[i]->hash(visible[i], hash);
+
+  return frameCacheable ? hash : 0;
+}
+
+// Frees what belongs to this scene only; the window and the loaded assets stay.
+static void releaseScene(Scene *scene) {
+  destroyRAObjects(&scene->objects);
+  destroyAnimations(&scene->animations);
+  destroySpatialIndex(&scene->spatialIndex);
+  destroyScenePlan(&scene->plan);
+  destroyDisplayList(&scene->displayList);
+}
+
+void destroyScene(Scene *scene) {
+  releaseScene(scene);
+  destroyBatch();
+  destroySharedThreadPool();
+  if (IsWindowReady()) unloadAssets();
+  scene = NULL;
+}
+
+static void readSceneFrame(Scene *scene, RenderTexture target, Image *frame);
+
+// Images loaded afterwards use textures downsampled by scale, cached in cacheDir when it is not
+// NULL, and startScene draws into a target of that scale. Timing is left untouched.
+void setProxyPreview(float scale, const char *cacheDir) {
+  assert((scale > 0.0f) && (scale <= 1.0f));
+  proxyScale = scale;
+  proxyCacheDir = cacheDir;
+}
+
+int getProxySegments(int segments) {
+  if (renderScale >= 1.0f) return segments;
+
+  int reduced = (int)ceilf(segments * renderScale);
+  int minimum = segments < PROXY_MIN_SEGMENTS ? segments : PROXY_MIN_SEGMENTS;
+  return reduced > minimum ? reduced : minimum;
+}
+
+static void renderProxyScene(Scene *scene, RenderTexture target) {
+  BeginTextureMode(target);
+  rlPushMatrix();
+  rlScalef(proxyScale, proxyScale, 1.0f);
+  renderScale = proxyScale;
+  drawSceneObjects(scene, getSceneViewport(scene));
+  renderScale = 1.0f;
+  rlPopMatrix();
+  EndTextureMode();
+
+  Rectangle source = {0, 0, (float)target.texture.width, -(float)target.texture.height};
+  Rectangle dest = {0, 0, (float)GetScreenWidth(), (float)GetScreenHeight()};
+
+  BeginDrawing();
+  ClearBackground(BLANK);
+  DrawTexturePro(target.texture, source, dest, (Vector2){0, 0}, 0.0f, WHITE);
+  if (scene->showMemoryStats) drawMemoryStats(10, 10);
+  EndDrawing();
+}
+
+void startScene(Scene *scene) {
+  SetTargetFPS(scene->timingMode == TIMING_FIXED_STEP ? scene->fps : 120);
+
+  double startTime = GetTime() - scene->time;
+  bool proxy = (proxyScale < 1.0f) && (scene->frameRing == NULL);
+  RenderTexture target = {0};
+  if (scene->frameRing != NULL) target = LoadRenderTexture(scene->width, scene->height);
+  if (proxy) {
+    int width = (int)ceilf(scene->width * proxyScale);
+    int height = (int)ceilf(scene->height * proxyScale);
+    target = LoadRenderTexture(width, height);
+  }
+
+  while (!WindowShouldClose()) {
+    if (IsKeyPressed(KEY_Q)) break;
+
+    if (scene->timingMode == TIMING_FIXED_STEP) {
+      stepScene(scene);
+    } else {
+      seekScene(scene, GetTime() - startTime);
+    }
+
+    if (proxy) {
+      renderProxyScene(scene, target);
+      continue;
+    }
+
+    if (scene->frameRing == NULL) {
+      renderScene(scene);
+      continue;
+    }
+
+    // Render once into the ring slot, then show the same texture in the window.
+    Image frame = beginFrameRingWrite(scene->frameRing);
+    readSceneFrame(scene, target, &frame);
+    endFrameRingWrite(scene->frameRing, scene->frame, scene->time);
+
+    Rectangle source = {0, 0, (float)scene->width, (float)scene->height};
+    Rectangle dest = {0, 0, (float)scene->width, (float)scene->height};
+
+    BeginDrawing();
+    ClearBackground(BLANK);
+    DrawTexturePro(target.texture, source, dest, (Vector2){0, 0}, 0.0f, WHITE);
+    EndDrawing();
+  }
+
+  if ((scene->frameRing != NULL) || proxy) UnloadRenderTexture(target);
+  unloadAssets();
+  CloseWindow();
+}
+
+static Image renderSceneToImage(Scene *scene, RenderTexture target) {
+  BeginTextureMode(target);
+  drawSceneObjects(scene, getSceneViewport(scene));
+  EndTextureMode();
+
+  Image frame = LoadImageFromTexture(target.texture);
+  ImageFlipVertical(&frame);
+
+  return frame;
+}
+
+Image captureSceneFrame(Scene *scene) {
+  RenderTexture target = LoadRenderTexture(scene->width, scene->height);
+  Image frame = renderSceneToImage(scene, target);
+  UnloadRenderTexture(target);
+
+  return frame;
+}
+
+// Renders one part of the frame, e.g. a tile, drawing only the objects filed under its cells.
+Image captureSceneRegion(Scene *scene, Rectangle area) {
+  assert((area.width >= 1.0f) && (area.height >= 1.0f));
+
+  RenderTexture target = LoadRenderTexture((int)area.width, (int)area.height);
+  BeginTextureMode(target);
+  rlPushMatrix();
+  rlTranslatef(-area.x, -area.y, 0.0f);
+  drawSceneObjects(scene, area);
+  rlPopMatrix();
+  EndTextureMode();
+
+  Image frame = LoadImageFromTexture(target.texture);
+  ImageFlipVertical(&frame);
+  UnloadRenderTexture(target);
+
+  return frame;
+}
+
+// Perceptual distance in YIQ space, normalized to 0..1.
+float comparePixels(Color a, Color b) {
+  float dr = (float)a.r - b.r;
+  float dg = (float)a.g - b.g;
+  float db = (float)a.b - b.b;
+
+  float y = dr * 0.29889531f + dg * 0.58662247f + db * 0.11448223f;
+  float i = dr * 0.59597799f - dg * 0.27417610f - db * 0.32180189f;
+  float q = dr * 0.21147017f - dg * 0.52261711f + db * 0.31114694f;
+  float delta = 0.5053f * y * y + 0.299f * i * i + 0.1957f * q * q;
+
+  return sqrtf(delta / 35215.0f);
+}
+
+GoldenResult compareImages(Image actual, Image expected, float tolerance) {
+  GoldenResult result = {false, 0, 0.0f, 0.0};
+
+  if ((actual.width != expected.width) || (actual.height != expected.height)) {
+    result.mismatchedPixels = actual.width * actual.height;
+    result.maxDelta = 1.0f;
+    return result;
+  }
+
+  Color *actualPixels = LoadImageColors(actual);
+  Color *expectedPixels = LoadImageColors(expected);
+
+  for (int i = 0; i < actual.width * actual.height; i++) {
+    float delta = comparePixels(actualPixels[i], expectedPixels[i]);
+    result.maxDelta = fmaxf(result.maxDelta, delta);
+    if (delta > tolerance) result.mismatchedPixels++;
+  }
+
+  UnloadImageColors(actualPixels);
+  UnloadImageColors(expectedPixels);
+
+  result.passed = result.mismatchedPixels == 0;
+  return result;
+}
+
+// Seeks the scene to each timestamp and compares the frame against goldenDir/name_N.png. A
+// missing golden frame fails the check; with update set, every golden is rewritten from the
+// current render instead.
+GoldenResult checkGoldenFrames(Scene *scene,
+                               const char *goldenDir,
+                               const char *name,
+                               const double *times,
+                               int timeCount,
+                               float tolerance,
+                               bool update) {
+  GoldenResult result = {true, 0, 0.0f, 0.0};
+  RenderTexture target = LoadRenderTexture(scene->width, scene->height);
+  char goldenPath[1024];
+
+  if (update) mkdir(goldenDir, 0755);
+
+  for (int i = 0; i < timeCount; i++) {
+    seekScene(scene, times[i]);
+
+    double renderStart = GetTime();
+    Image frame = renderSceneToImage(scene, target);
+    result.renderTime += GetTime() - renderStart;
+
+    snprintf(goldenPath, sizeof(goldenPath), "%s/%s_%d.png", goldenDir, name, i);
+
+    if (update) {
+      if (ExportImage(frame, goldenPath)) {
+        TraceLog(LOG_INFO, "RayAnim: Wrote golden frame %s", goldenPath);
+      } else {
+        TraceLog(LOG_ERROR, "RayAnim: Could not write golden frame %s", goldenPath);
+        result.passed = false;
+      }
+    } else if (!FileExists(goldenPath)) {
+      TraceLog(LOG_ERROR, "RayAnim: Missing golden frame %s", goldenPath);
+      result.passed = false;
+    } else {
+      Image golden = LoadImage(goldenPath);
+      GoldenResult each = compareImages(frame, golden, tolerance);
+      UnloadImage(golden);
+
+      result.passed = result.passed && each.passed;
+      result.mismatchedPixels += each.mismatchedPixels;
+      result.maxDelta = fmaxf(result.maxDelta, each.maxDelta);
+
+      if (!each.passed)
+        TraceLog(LOG_ERROR,
+                 "RayAnim: %s differs at t=%.3f (%i pixels, max delta %.3f)",
+                 goldenPath,
+                 times[i],
+                 each.mismatchedPixels,
+                 each.maxDelta);
+    }
+
+    UnloadImage(frame);
+  }
+
+  UnloadRenderTexture(target);
+
+  TraceLog(result.passed ? LOG_INFO : LOG_ERROR,
+           "RayAnim: Golden test %s %s (%.2f ms render)",
+           name,
+           result.passed ? "passed" : "FAILED",
+           result.renderTime * 1000.0);
+
+  return result;
+}
+
+static bool isSceneFinished(Scene *scene) {
+  bool planFinished = !scene->compiled || (scene->plan.currentEntry == scene->plan.entries.count);
+  return planFinished && (scene->currentAnimation == NULL) && (scene->animations.count == 0);
+}
+
+static bool copyFile(const char *from, const char *to) {
+  int size = 0;
+  unsigned char *data = LoadFileData(from, &size);
+  if (data == NULL) return false;
+
+  bool saved = SaveFileData(to, data, size);
+  UnloadFileData(data);
+
+  return saved;
+}
+
+// Downscaling averages every source pixel a target pixel covers, weighted by the covered area.
+// Colors are averaged in linear light; averaging the sRGB values directly darkens edges and thin
+// strokes. Pixels are premultiplied, and the sRGB curve applies to the straight color, so each
+// pixel is un-premultiplied before it is linearized and premultiplied again in linear light.
+// Both passes are plain loops over float rows that the compiler can vectorize.
+
+static float srgbToLinear[256];
+static unsigned char linearToSrgb[4096];
+static pthread_once_t gammaTablesOnce = PTHREAD_ONCE_INIT;
+
+static void initGammaTables(void) {
+  for (int i = 0; i < 256; i++) {
+    float value = i / 255.0f;
+    srgbToLinear[i] =
+        value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+  }
+
+  for (int i = 0; i < 4096; i++) {
+    float value = i / 4095.0f;
+    value = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+    linearToSrgb[i] = (unsigned char)(value * 255.0f + 0.5f);
+  }
+}
+
+// Source pixels first..first + taps - 1 contribute to each target pixel with the given weights.
+typedef struct ResampleAxis {
+  int taps;
+  int *first;
+  float *weights;
+} ResampleAxis;
+
+static void initResampleAxis(ResampleAxis *axis, int sourceSize, int targetSize) {
+  float scale = (float)sourceSize / targetSize;
+  int taps = (int)ceilf(scale) + 1;
+  axis->taps = taps < sourceSize ? taps : sourceSize;
+  axis->first = allocateMemory(MEMORY_FRAMES, targetSize * sizeof(int));
+  axis->weights = allocateMemory(MEMORY_FRAMES, targetSize * axis->taps * sizeof(float));
+  assert((axis->first != NULL) && (axis->weights != NULL));
+
+  for (int i = 0; i < targetSize; i++) {
+    float start = i * scale;
+    float end = start + scale;
+    int first = (int)start;
+    if (first > sourceSize - axis->taps) first = sourceSize - axis->taps;
+
+    axis->first[i] = first;
+    for (int t = 0; t < axis->taps; t++) {
+      float covered = fminf(end, first + t + 1.0f) - fmaxf(start, first + t);
+      axis->weights[i * axis->taps + t] = fmaxf(covered, 0.0f) / scale;
+    }
+  }
+}
+
+static void destroyResampleAxis(ResampleAxis *axis) {
+  releaseMemory(axis->first);
+  releaseMemory(axis->weights);
+}
+
+// The scratch buffer holds two rows of source width * 4 floats.
+static void resampleImage(
+    Image source, Image target, ResampleAxis *columns, ResampleAxis *rows, float *scratch) {
+  int rowLength = source.width * 4;
+  float *restrict linear = scratch;
+  float *restrict sum = scratch + rowLength;
+  const unsigned char *src = (const unsigned char *)source.data;
+  unsigned char *dst = (unsigned char *)target.data;
+
+  for (int y = 0; y < target.height; y++) {
+    memset(sum, 0, rowLength * sizeof(float));
+
+    for (int t = 0; t < rows->taps; t++) {
+      float weight = rows->weights[y * rows->taps + t];
+      if (weight <= 0.0f) continue;
+
+      const unsigned char *row = src + (rows->first[y] + t) * rowLength;
+      for (int i = 0; i < rowLength; i += 4) {
+        int alpha = row[i + 3];
+        float coverage = alpha / 255.0f;
+
+        for (int c = 0; c < 3; c++) {
+          int straight = alpha > 0 ? (row[i + c] * 255 + alpha / 2) / alpha : 0;
+          linear[i + c] = srgbToLinear[straight < 255 ? straight : 255] * coverage;
+        }
+        linear[i + 3] = coverage;
+      }
+
+      for (int i = 0; i < rowLength; i++) sum[i] += weight * linear[i];
+    }
+
+    unsigned char *out = dst + y * target.width * 4;
+    for (int x = 0; x < target.width; x++) {
+      const float *pixels = sum + columns->first[x] * 4;
+      const float *weights = columns->weights + x * columns->taps;
+      float pixel[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+      for (int t = 0; t < columns->taps; t++)
+        for (int c = 0; c < 4; c++) pixel[c] += weights[t] * pixels[t * 4 + c];
+
+      float coverage = fminf(fmaxf(pixel[3], 0.0f), 1.0f);
+      for (int c = 0; c < 3; c++) {
+        float straight = coverage > 0.0f ? fminf(fmaxf(pixel[c] / coverage, 0.0f), 1.0f) : 0.0f;
+        int encoded = linearToSrgb[(int)(straight * 4095.0f + 0.5f)];
+        out[x * 4 + c] = (unsigned char)(encoded * coverage + 0.5f);
+      }
+      out[x * 4 + 3] = (unsigned char)(coverage * 255.0f + 0.5f);
+    }
+  }
+}
+
+// Downscales an R8G8B8A8 image into target, which must already have its size and pixel buffer.
+void downscaleImage(Image source, Image *target) {
+  assert(source.format == PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+  assert((target->width <= source.width) && (target->height <= source.height));
+
+  pthread_once(&gammaTablesOnce, initGammaTables);
+
+  ResampleAxis columns;
+  ResampleAxis rows;
+  initResampleAxis(&columns, source.width, target->width);
+  initResampleAxis(&rows, source.height, target->height);
+  float *scratch = allocateMemory(MEMORY_FRAMES, source.width * 8 * sizeof(float));
+  assert(scratch != NULL);
+
+  target->mipmaps = 1;
+  target->format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+  resampleImage(source, *target, &columns, &rows, scratch);
+
+  releaseMemory(scratch);
+  destroyResampleAxis(&columns);
+  destroyResampleAxis(&rows);
+}
+
+// How one rendition is produced from the frames rendered at the scene's size. The filter taps
+// are computed once per recording.
+typedef struct ExportRendition {
+  ResampleAxis columns;
+  ResampleAxis rows;
+} ExportRendition;
+
+// One frame in flight through the export pipeline. Output 0 is the frame at the scene's size and
+// output i > 0 is rendition i - 1; each is encoded by its own task. The pixel buffers are
+// allocated once and reused; a slot can only be refilled after all of its tasks have finished.
+typedef struct ExportSlot {
+  Scene *scene;
+  ExportRendition *renditions;
+  Image frame;
+  Image renditionFrames[MAX_RENDITIONS];
+  float *scratch[MAX_RENDITIONS];
+  RATaskGroup group;
+  bool writeCache;
+  long frameNumber;
+  RAHash hash;
+} ExportSlot;
+
+static void getExportPaths(
+    Scene *scene, int output, long frame, RAHash hash, char *framePath, char *cachePath) {
+  const char *outputDir =
+      output == 0 ? scene->outputDir : scene->renditions[output - 1].outputDir;
+  snprintf(framePath, 1024, "%s/frame_%06ld.png", outputDir, frame);
+
+  if (scene->cacheDir == NULL) return;
+  if (output == 0) {
+    snprintf(cachePath, 1024, "%s/%016llx.png", scene->cacheDir, (unsigned long long)hash);
+  } else {
+    snprintf(cachePath,
+             1024,
+             "%s/%016llx_%dx%d.png",
+             scene->cacheDir,
+             (unsigned long long)hash,
+             scene->renditions[output - 1].width,
+             scene->renditions[output - 1].height);
+  }
+}
+
+static bool isExportOutputDue(Scene *scene, int output, long frame) {
+  if (output == 0) return scene->outputDir != NULL;
+  return frame % scene->renditions[output - 1].frameInterval == 0;
+}
+
+static void encodeExportSlot(void *context, int start, int end) {
+  (void)end;
+  ExportSlot *slot = (ExportSlot *)context;
+  int output = start;
+
+  Image frame = slot->frame;
+  if (output > 0) {
+    ExportRendition *each = &slot->renditions[output - 1];
+    frame = slot->renditionFrames[output - 1];
+    resampleImage(slot->frame, frame, &each->columns, &each->rows, slot->scratch[output - 1]);
+  }
+
+  char framePath[1024];
+  char cachePath[1024];
+  getExportPaths(slot->scene, output, slot->frameNumber, slot->hash, framePath, cachePath);
+
+  if (!ExportImage(frame, framePath)) {
+    TraceLog(LOG_ERROR, "RayAnim: Could not write frame %s", framePath);
+    return;
+  }
+  if (!slot->writeCache) return;
+
+  // Later frames may hit this cache entry while it is being written, so publish it atomically.
+  char tempPath[1040];
+  snprintf(tempPath, sizeof(tempPath), "%s.%ld.tmp", cachePath, slot->frameNumber);
+  if (!copyFile(framePath, tempPath) || (rename(tempPath, cachePath) != 0)) {
+    TraceLog(LOG_WARNING, "RayAnim: Could not cache frame %s", cachePath);
+    remove(tempPath);
+  }
+}
+
+// Copies every output due for this frame from the cache, or returns false if any is missing.
+static bool copyCachedExport(Scene *scene, RAHash hash) {
+  char framePath[1024];
+  char cachePath[1024];
+
+  for (int output = 0; output <= scene->renditionCount; output++) {
+    if (!isExportOutputDue(scene, output, scene->frame)) continue;
+
+    getExportPaths(scene, output, scene->frame, hash, framePath, cachePath);
+    if (!FileExists(cachePath)) return false;
+  }
+
+  for (int output = 0; output <= scene->renditionCount; output++) {
+    if (!isExportOutputDue(scene, output, scene->frame)) continue;
+
+    getExportPaths(scene, output, scene->frame, hash, framePath, cachePath);
+    if (!copyFile(cachePath, framePath)) return false;
+  }
+
+  return true;
+}
+
+// Reads the render target straight into an existing buffer. The scene is drawn with the
+// projection flipped, so the rows come back top first and the target texture is stored upright.
+// The flip reverses the winding of every triangle, so culling is off while drawing.
+static void readSceneFrame(Scene *scene, RenderTexture target, Image *frame) {
+  BeginTextureMode(target);
+  rlMatrixMode(RL_PROJECTION);
+  rlLoadIdentity();
+  rlOrtho(0, target.texture.width, 0, target.texture.height, 0.0, 1.0);
+  rlMatrixMode(RL_MODELVIEW);
+  rlDisableBackfaceCulling();
+
+  drawSceneObjects(scene, getSceneViewport(scene));
+
+  rlDrawRenderBatchActive();
+  glReadPixels(0, 0, frame->width, frame->height, GL_RGBA, GL_UNSIGNED_BYTE, frame->data);
+  rlEnableBackfaceCulling();
+  EndTextureMode();
+}
+
+// Everything one recording needs between frames, so that the render server can interleave the
+// frames of several recordings on its render thread.
+typedef struct RecordSession {
+  Scene *scene;
+  RAThreadPool *pool;
+  RenderTexture target;
+  ExportRendition renditions[MAX_RENDITIONS];
+  ExportSlot slots[EXPORT_PIPELINE_DEPTH];
+  Image sequenceFrame;
+  bool exporting;
+  long renderedCount;
+  long slotIdx;
+} RecordSession;
+
+static void beginRecordSession(RecordSession *session, Scene *scene) {
+  assert((scene->outputDir != NULL) || (scene->frameRing != NULL) ||
+         (scene->frameSequence != NULL) || (scene->renditionCount > 0));
+  if (proxyScale < 1.0f) TraceLog(LOG_WARNING, "RayAnim: Recording with proxy textures");
+
+  if (scene->outputDir != NULL) mkdir(scene->outputDir, 0755);
+  if (scene->cacheDir != NULL) mkdir(scene->cacheDir, 0755);
+  for (int i = 0; i < scene->renditionCount; i++) mkdir(scene->renditions[i].outputDir, 0755);
+
+  session->scene = scene;
+  session->pool = getSharedThreadPool();
+  session->target = LoadRenderTexture(scene->width, scene->height);
+  session->exporting = (scene->outputDir != NULL) || (scene->renditionCount > 0);
+  session->renderedCount = 0;
+  session->slotIdx = 0;
+
+  // Frames for the sequence are read back into the ring slot when there is one.
+  session->sequenceFrame = (Image){0};
+  if ((scene->frameSequence != NULL) && (scene->frameRing == NULL)) {
+    session->sequenceFrame =
+        (Image){allocateMemory(MEMORY_FRAMES, scene->width * scene->height * 4),
+                scene->width,
+                scene->height,
+                1,
+                PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+    assert(session->sequenceFrame.data != NULL);
+  }
+
+  pthread_once(&gammaTablesOnce, initGammaTables);
+  for (int r = 0; r < scene->renditionCount; r++) {
+    initResampleAxis(&session->renditions[r].columns, scene->width, scene->renditions[r].width);
+    initResampleAxis(&session->renditions[r].rows, scene->height, scene->renditions[r].height);
+  }
+
+  for (int i = 0; i < EXPORT_PIPELINE_DEPTH; i++) {
+    ExportSlot *slot = &session->slots[i];
+    slot->scene = scene;
+    slot->renditions = session->renditions;
+    slot->frame = (Image){allocateMemory(MEMORY_FRAMES, scene->width * scene->height * 4),
+                          scene->width,
+                          scene->height,
+                          1,
+                          PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+    slot->group = (RATaskGroup){0};
+    assert(slot->frame.data != NULL);
+
+    for (int r = 0; r < scene->renditionCount; r++) {
+      int width = scene->renditions[r].width;
+      int height = scene->renditions[r].height;
+      slot->renditionFrames[r] = (Image){allocateMemory(MEMORY_FRAMES, width * height * 4),
+                                         width,
+                                         height,
+                                         1,
+                                         PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+      slot->scratch[r] = allocateMemory(MEMORY_FRAMES, scene->width * 8 * sizeof(float));
+      assert((slot->renditionFrames[r].data != NULL) && (slot->scratch[r] != NULL));
+    }
+  }
+
+  seekScene(scene, (double)scene->frame / scene->fps);
+}
+
+// Renders and submits the current frame, then advances the scene. Returns false once the last
+// frame has been submitted.
+static bool stepRecordSession(RecordSession *session) {
+  Scene *scene = session->scene;
+
+  Image rendered = {0};
+  if (scene->frameRing != NULL) {
+    rendered = beginFrameRingWrite(scene->frameRing);
+    readSceneFrame(scene, session->target, &rendered);
+    endFrameRingWrite(scene->frameRing, scene->frame, scene->time);
+  }
+
+  if (scene->frameSequence != NULL) {
+    if (rendered.data == NULL) {
+      rendered = session->sequenceFrame;
+      readSceneFrame(scene, session->target, &rendered);
+    }
+    if (!writeFrameSequence(scene->frameSequence, scene->frame, rendered))
+      TraceLog(LOG_ERROR, "RayAnim: Could not write frame %ld to the frame sequence", scene->frame);
+  }
+
+  bool due = false;
+  for (int output = 0; output <= scene->renditionCount; output++)
+    due = due || isExportOutputDue(scene, output, scene->frame);
+
+  if (session->exporting && due) {
+    ExportSlot *slot = &session->slots[session->slotIdx % EXPORT_PIPELINE_DEPTH];
+    waitForTaskGroup(session->pool, &slot->group);
+
+    slot->frameNumber = scene->frame;
+    slot->hash = scene->cacheDir != NULL ? hashSceneFrame(scene) : 0;
+    slot->writeCache = slot->hash != 0;
+    bool cached = slot->writeCache && copyCachedExport(scene, slot->hash);
+
+    if (!cached) {
+      if (rendered.data != NULL) {
+        memcpy(slot->frame.data, rendered.data, scene->width * scene->height * 4);
+      } else {
+        readSceneFrame(scene, session->target, &slot->frame);
+      }
+
+      for (int output = 0; output <= scene->renditionCount; output++)
+        if (isExportOutputDue(scene, output, scene->frame))
+          submitTask(session->pool, &slot->group, encodeExportSlot, slot, output, output + 1);
+
+      session->renderedCount++;
+      session->slotIdx++;
+    }
+  }
+
+  if (isSceneFinished(scene)) return false;
+
+  stepScene(scene);
+  return true;
+}
+
+// Waits for the frames still being encoded and frees the session's buffers.
+static void endRecordSession(RecordSession *session) {
+  Scene *scene = session->scene;
+
+  releaseMemory(session->sequenceFrame.data);
+
+  for (int i = 0; i < EXPORT_PIPELINE_DEPTH; i++) {
+    waitForTaskGroup(session->pool, &session->slots[i].group);
+    releaseMemory(session->slots[i].frame.data);
+
+    for (int r = 0; r < scene->renditionCount; r++) {
+      releaseMemory(session->slots[i].renditionFrames[r].data);
+      releaseMemory(session->slots[i].scratch[r]);
+    }
+  }
+
+  for (int r = 0; r < scene->renditionCount; r++) {
+    destroyResampleAxis(&session->renditions[r].columns);
+    destroyResampleAxis(&session->renditions[r].rows);
+  }
+
+  TraceLog(LOG_INFO,
+           "RayAnim: Recorded %ld frames (%ld rendered)",
+           scene->frame + 1,
+           session->renderedCount);
+
+  UnloadRenderTexture(session->target);
+}
+
+// Frames are a pure function of the evaluated scene state, so a frame whose hash is already in
+// the cache directory is copied from there instead of being rasterized again.
+//
+// Updating and rendering need the GL context and stay on this thread, while PNG encoding runs
+// on the shared pool. Up to EXPORT_PIPELINE_DEPTH frames are in flight; when the encoders fall
+// behind, the loop waits on the oldest slot (helping to encode it) before reusing it.
+//
+// Renditions are downscaled from the same rendered frame by the encode tasks, so each one costs
+// a filter pass and an encode rather than another evaluation and render of the scene.
+void recordScene(Scene *scene) {
+  RecordSession session;
+
+  beginRecordSession(&session, scene);
+  while (stepRecordSession(&session)) continue;
+  endRecordSession(&session);
+
+  unloadAssets();
+  CloseWindow();
+}
+
+// ----------------------------------------- Memory ------------------------------------------
+
+// Every block carries a small header with its size and category so that releasing it can update
+// the counters. GPU resources are not allocated here and are counted with trackMemory().
+
+typedef struct MemoryHeader {
+  size_t size;
+  size_t category;
+} MemoryHeader;
+
+static void *reallocateDefault(void *context, void *block, size_t size) {
+  (void)context;
+  return realloc(block, size);
+}
+
+static void releaseDefault(void *context, void *block) {
+  (void)context;
+  free(block);
+}
+
+static RAAllocator allocator = {NULL, reallocateDefault, releaseDefault};
+static size_t memoryCurrent[MEMORY_CATEGORY_COUNT];
+static size_t memoryPeak[MEMORY_CATEGORY_COUNT];
+static size_t memoryTotalCurrent = 0;
+static size_t memoryTotalPeak = 0;
+
+// Blocks must be released by the allocator that made them, so set it before creating a scene.
+void setAllocator(RAAllocator newAllocator) {
+  assert(memoryTotalCurrent == 0);
+  allocator = newAllocator;
+}
+
+static void raisePeak(size_t *peak, size_t value) {
+  size_t seen = __atomic_load_n(peak, __ATOMIC_RELAXED);
+  while ((value > seen) &&
+         !__atomic_compare_exchange_n(peak, &seen, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
+}
+
+void trackMemory(MemoryCategory category, int64_t delta) {
+  size_t current = __atomic_add_fetch(&memoryCurrent[category], (size_t)delta, __ATOMIC_RELAXED);
+  size_t total = __atomic_add_fetch(&memoryTotalCurrent, (size_t)delta, __ATOMIC_RELAXED);
+
+  raisePeak(&memoryPeak[category], current);
+  raisePeak(&memoryTotalPeak, total);
+}
+
+void *allocateMemory(MemoryCategory category, size_t size) {
+  return reallocateMemory(category, NULL, size);
+}
+
+void *reallocateMemory(MemoryCategory category, void *block, size_t size) {
+  MemoryHeader *header = block != NULL ? (MemoryHeader *)block - 1 : NULL;
+  size_t oldSize = header != NULL ? header->size : 0;
+  if (header != NULL) category = (MemoryCategory)header->category;
+
+  header = allocator.reallocate(allocator.context, header, sizeof(MemoryHeader) + size);
+  if (header == NULL) return NULL;
+
+  header->size = size;
+  header->category = category;
+  trackMemory(category, (int64_t)size - (int64_t)oldSize);
+
+  return header + 1;
+}
+
+void releaseMemory(void *block) {
+  if (block == NULL) return;
+
+  MemoryHeader *header = (MemoryHeader *)block - 1;
+  trackMemory((MemoryCategory)header->category, -(int64_t)header->size);
+  allocator.release(allocator.context, header);
+}
+
+MemoryStats getMemoryStats(void) {
+  MemoryStats stats;
+
+  for (int i = 0; i < MEMORY_CATEGORY_COUNT; i++) {
+    stats.current[i] = __atomic_load_n(&memoryCurrent[i], __ATOMIC_RELAXED);
+    stats.peak[i] = __atomic_load_n(&memoryPeak[i], __ATOMIC_RELAXED);
+  }
+
+  stats.totalCurrent = __atomic_load_n(&memoryTotalCurrent, __ATOMIC_RELAXED);
+  stats.totalPeak = __atomic_load_n(&memoryTotalPeak, __ATOMIC_RELAXED);
+  return stats;
+}
+
+const char *getMemoryCategoryName(MemoryCategory category) {
+  static const char *names[MEMORY_CATEGORY_COUNT] = {
+      "scene", "objects", "textures", "fonts", "frames"};
+
+  return names[category];
+}
+
+void drawMemoryStats(int x, int y) {
+  MemoryStats stats = getMemoryStats();
+  const float mb = 1024.0f * 1024.0f;
+
+  DrawRectangle(x, y, 240, 20 * (MEMORY_CATEGORY_COUNT + 1) + 10, Fade(BLACK, 0.6f));
+
+  for (int i = 0; i < MEMORY_CATEGORY_COUNT; i++)
+    DrawText(TextFormat("%-9s %7.2f MB (peak %.2f)",
+                        getMemoryCategoryName(i),
+                        stats.current[i] / mb,
+                        stats.peak[i] / mb),
+             x + 8,
+             y + 8 + 20 * i,
+             10,
+             RAYWHITE);
+
+  DrawText(TextFormat("%-9s %7.2f MB (peak %.2f)",
+                      "total",
+                      stats.totalCurrent / mb,
+                      stats.totalPeak / mb),
+           x + 8,
+           y + 8 + 20 * MEMORY_CATEGORY_COUNT,
+           10,
+           RAYWHITE);
+}
+
+// --------------------------------------- Thread Pool ---------------------------------------
+
+// Every worker owns a queue and takes its newest task first; when it runs dry it steals the
+// oldest task of another queue. The last queue belongs to threads outside the pool, which help
+// out while they wait. A pool without workers runs every task inline, in submission order.
+
+DEFINE_DEQUE(RATasks, RATask, MEMORY_SCENE)
+
+static void pushToTaskQueue(RATaskQueue *queue, RATask task) {
+  pthread_mutex_lock(&queue->lock);
+  pushToRATasks(&queue->tasks, task);
+  pthread_mutex_unlock(&queue->lock);
+}
+
+static bool popFromTaskQueue(RATaskQueue *queue, RATask *task, bool newest) {
+  pthread_mutex_lock(&queue->lock);
+
+  bool found = queue->tasks.count > 0;
+  if (found) *task = newest ? popFromRATasks(&queue->tasks) : popFirstFromRATasks(&queue->tasks);
+
+  pthread_mutex_unlock(&queue->lock);
+  return found;
+}
+
+static bool takeTask(RAThreadPool *pool, int queueIdx, RATask *task) {
+  int queueCount = pool->workerCount + 1;
+  bool found = popFromTaskQueue(&pool->queues[queueIdx], task, true);
+
+  for (int i = 1; (i < queueCount) && !found; i++)
+    found = popFromTaskQueue(&pool->queues[(queueIdx + i) % queueCount], task, false);
+
+  if (found) {
+    pthread_mutex_lock(&pool->lock);
+    pool->queuedTasks--;
+    pthread_mutex_unlock(&pool->lock);
+  }
+
+  return found;
+}
+
+static int getCallerQueue(RAThreadPool *pool) {
+  int *queueIdx = pthread_getspecific(pool->queueKey);
+  return queueIdx != NULL ? *queueIdx : pool->workerCount;
+}
+
+static void runTask(RAThreadPool *pool, RATask task) {
+  task.run(task.context, task.start, task.end);
+
+  pthread_mutex_lock(&pool->lock);
+  if (--task.group->pending == 0) pthread_cond_broadcast(&pool->done);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+typedef struct WorkerArgs {
+  RAThreadPool *pool;
+  int queueIdx;
+} WorkerArgs;
+
+static void *runWorker(void *args) {
+  WorkerArgs workerArgs = *(WorkerArgs *)args;
+  RAThreadPool *pool = workerArgs.pool;
+  releaseMemory(args);
+
+  pthread_setspecific(pool->queueKey, &pool->queueIds[workerArgs.queueIdx]);
+
+  for (;;) {
+    RATask task;
+    if (takeTask(pool, workerArgs.queueIdx, &task)) {
+      runTask(pool, task);
+      continue;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    while ((pool->queuedTasks == 0) && !pool->stopping) pthread_cond_wait(&pool->wake, &pool->lock);
+    bool stop = pool->stopping && (pool->queuedTasks == 0);
+    pthread_mutex_unlock(&pool->lock);
+
+    if (stop) break;
+  }
+
+  return NULL;
+}
+
+void initThreadPool(RAThreadPool *pool, int workerCount) {
+  assert(workerCount >= 0);
+
+  pool->workerCount = workerCount;
+  pool->queuedTasks = 0;
+  pool->stopping = false;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  pthread_key_create(&pool->queueKey, NULL);
+
+  int threadCount = workerCount > 0 ? workerCount : 1;
+  pool->queues = allocateMemory(MEMORY_SCENE, (workerCount + 1) * sizeof(RATaskQueue));
+  pool->queueIds = allocateMemory(MEMORY_SCENE, (workerCount + 1) * sizeof(int));
+  pool->threads = allocateMemory(MEMORY_SCENE, threadCount * sizeof(pthread_t));
+  assert((pool->queues != NULL) && (pool->queueIds != NULL) && (pool->threads != NULL));
+  memset(pool->queues, 0, (workerCount + 1) * sizeof(RATaskQueue));
+
+  for (int i = 0; i <= workerCount; i++) {
+    pthread_mutex_init(&pool->queues[i].lock, NULL);
+    pool->queueIds[i] = i;
+  }
+
+  for (int i = 0; i < workerCount; i++) {
+    WorkerArgs *args = allocateMemory(MEMORY_SCENE, sizeof(WorkerArgs));
+    assert(args != NULL);
+    *args = (WorkerArgs){pool, i};
+
+    int failed = pthread_create(&pool->threads[i], NULL, runWorker, args);
+    assert(failed == 0);
+    (void)failed;
+  }
+}
+
+void submitTask(RAThreadPool *pool,
+                RATaskGroup *group,
+                void (*run)(void *, int, int),
+                void *context,
+                int start,
+                int end) {
+  RATask task = {run, context, start, end, group};
+
+  pthread_mutex_lock(&pool->lock);
+  group->pending++;
+  pthread_mutex_unlock(&pool->lock);
+
+  if (pool->workerCount == 0) {
+    runTask(pool, task);
+    return;
+  }
+
+  pushToTaskQueue(&pool->queues[getCallerQueue(pool)], task);
+
+  pthread_mutex_lock(&pool->lock);
+  pool->queuedTasks++;
+  pthread_cond_signal(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void waitForTaskGroup(RAThreadPool *pool, RATaskGroup *group) {
+  for (;;) {
+    RATask task;
+    if (takeTask(pool, getCallerQueue(pool), &task)) {
+      runTask(pool, task);
+      continue;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    while ((group->pending > 0) && (pool->queuedTasks == 0))
+      pthread_cond_wait(&pool->done, &pool->lock);
+    bool finished = group->pending == 0;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (finished) return;
+  }
+}
+
+// Splits [0, count) into chunks and blocks until all of them have run. Chunks write only to
+// their own range, so results land in the same place whatever thread ran them.
+void parallelFor(RAThreadPool *pool,
+                 int count,
+                 int chunkSize,
+                 void (*run)(void *, int, int),
+                 void *context) {
+  assert(chunkSize > 0);
+
+  RATaskGroup group = {0};
+
+  for (int start = 0; start < count; start += chunkSize) {
+    int end = start + chunkSize < count ? start + chunkSize : count;
+    submitTask(pool, &group, run, context, start, end);
+  }
+
+  waitForTaskGroup(pool, &group);
+}
+
+void destroyThreadPool(RAThreadPool *pool) {
+  pthread_mutex_lock(&pool->lock);
+  pool->stopping = true;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (int i = 0; i < pool->workerCount; i++) pthread_join(pool->threads[i], NULL);
+
+  for (int i = 0; i <= pool->workerCount; i++) {
+    pthread_mutex_destroy(&pool->queues[i].lock);
+    destroyRATasks(&pool->queues[i].tasks);
+  }
+
+  pthread_key_delete(pool->queueKey);
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->wake);
+  pthread_cond_destroy(&pool->done);
+  releaseMemory(pool->queues);
+  releaseMemory(pool->queueIds);
+  releaseMemory(pool->threads);
+}
+
+static RAThreadPool sharedPool;
+static bool sharedPoolReady = false;
+static int sharedPoolSize = -1;
+static pthread_mutex_t sharedPoolLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Must be called before the shared pool is first used; 0 runs everything on the calling thread.
+void setSharedThreadPoolSize(int workerCount) {
+  assert(!sharedPoolReady);
+  sharedPoolSize = workerCount;
+}
+
+// Scenes on different threads may ask for the pool at the same time. The lock is only taken
+// until the pool exists.
+RAThreadPool *getSharedThreadPool(void) {
+  if (__atomic_load_n(&sharedPoolReady, __ATOMIC_ACQUIRE)) return &sharedPool;
+
+  pthread_mutex_lock(&sharedPoolLock);
+  if (!sharedPoolReady) {
+    int workerCount = sharedPoolSize;
+    if (workerCount < 0) workerCount = (int)sysconf(_SC_NPROCESSORS_ONLN) - 1;
+
+    initThreadPool(&sharedPool, workerCount > 0 ? workerCount : 0);
+    __atomic_store_n(&sharedPoolReady, true, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&sharedPoolLock);
+
+  return &sharedPool;
+}
+
+void destroySharedThreadPool(void) {
+  pthread_mutex_lock(&sharedPoolLock);
+  if (sharedPoolReady) {
+    destroyThreadPool(&sharedPool);
+    __atomic_store_n(&sharedPoolReady, false, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&sharedPoolLock);
+}
+
+// --------------------------------------- Frame Ring ----------------------------------------
+
+// A POSIX shared memory ring that a local consumer maps to read frames in place. The producer
+// is the only writer of slots and of writeSequence; the consumer only writes readSequence, which
+// the FRAME_RING_BLOCK policy uses to stop the producer from overwriting unread frames.
+
+static double getMonotonicTime(void);
+
+static size_t alignToFrameRing(size_t size) {
+  return (size + FRAME_RING_ALIGN - 1) / FRAME_RING_ALIGN * FRAME_RING_ALIGN;
+}
+
+static RAFrameSlot *getFrameRingSlot(RAFrameRing *ring, uint64_t sequence) {
+  size_t offset = alignToFrameRing(sizeof(RAFrameRingHeader)) +
+                  (sequence % ring->header->slotCount) * ring->header->slotStride;
+  return (RAFrameSlot *)(ring->memory + offset);
+}
+
+static unsigned char *getFrameRingPixels(RAFrameSlot *slot) {
+  return (unsigned char *)slot + alignToFrameRing(sizeof(RAFrameSlot));
+}
+
+static bool mapFrameRing(RAFrameRing *ring, size_t size) {
+  void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+  if (memory == MAP_FAILED) {
+    TraceLog(LOG_ERROR, "RayAnim: Failed to map frame ring %s", ring->name);
+    close(ring->fd);
+    if (ring->owner) shm_unlink(ring->name);
+    return false;
+  }
+
+  ring->memory = (unsigned char *)memory;
+  ring->size = size;
+  ring->header = (RAFrameRingHeader *)memory;
+  trackMemory(MEMORY_FRAMES, (int64_t)size);
+  return true;
+}
+
+// name follows shm_open() rules, e.g. "/rayanim". An existing ring of the same name is replaced.
+bool createFrameRing(RAFrameRing *ring,
+                     const char *name,
+                     int width,
+                     int height,
+                     int slotCount,
+                     FrameRingPolicy policy) {
+  assert((width > 0) && (height > 0) && (slotCount > 1));
+
+  snprintf(ring->name, sizeof(ring->name), "%s", name);
+  ring->owner = true;
+
+  shm_unlink(ring->name);
+  ring->fd = shm_open(ring->name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (ring->fd < 0) {
+    TraceLog(LOG_ERROR, "RayAnim: Failed to create frame ring %s", ring->name);
+    return false;
+  }
+
+  size_t slotStride =
+      alignToFrameRing(sizeof(RAFrameSlot)) + alignToFrameRing((size_t)width * height * 4);
+  size_t size = alignToFrameRing(sizeof(RAFrameRingHeader)) + slotStride * slotCount;
+
+  if (ftruncate(ring->fd, (off_t)size) != 0) {
+    TraceLog(LOG_ERROR, "RayAnim: Failed to size frame ring %s", ring->name);
+    close(ring->fd);
+    shm_unlink(ring->name);
+    return false;
+  }
+
+  if (!mapFrameRing(ring, size)) return false;
+
+  memset(ring->memory, 0, size);
+  *ring->header = (RAFrameRingHeader){FRAME_RING_MAGIC,
+                                      FRAME_RING_VERSION,
+                                      (uint32_t)width,
+                                      (uint32_t)height,
+                                      (uint32_t)slotCount,
+                                      (uint32_t)policy,
+                                      slotStride,
+                                      0,
+                                      0};
+
+  TraceLog(LOG_INFO,
+           "RayAnim: Created frame ring %s (%d slots, %.1f MB)",
+           ring->name,
+           slotCount,
+           size / (1024.0 * 1024.0));
+  return true;
+}
+
+bool openFrameRing(RAFrameRing *ring, const char *name) {
+  snprintf(ring->name, sizeof(ring->name), "%s", name);
+  ring->owner = false;
+
+  ring->fd = shm_open(ring->name, O_RDWR, 0);
+  struct stat info;
+  if ((ring->fd < 0) || (fstat(ring->fd, &info) != 0)) {
+    TraceLog(LOG_ERROR, "RayAnim: Failed to open frame ring %s", ring->name);
+    if (ring->fd >= 0) close(ring->fd);
+    return false;
+  }
+
+  size_t headerSize = alignToFrameRing(sizeof(RAFrameRingHeader));
+  size_t size = (size_t)info.st_size;
+  if (size < headerSize) {
+    TraceLog(LOG_ERROR, "RayAnim: %s is not a compatible frame ring", ring->name);
+    close(ring->fd);
+    return false;
+  }
+
+  if (!mapFrameRing(ring, size)) return false;
+
+  // Touching a slot past the end of the object would raise SIGBUS, so the layout must fit.
+  RAFrameRingHeader *header = ring->header;
+  uint64_t slotSize =
+      alignToFrameRing(sizeof(RAFrameSlot)) + (uint64_t)header->width * header->height * 4;
+  bool fits = (header->slotCount > 0) && (header->slotStride >= slotSize) &&
+              (header->slotStride <= (size - headerSize) / header->slotCount);
+
+  if ((header->magic != FRAME_RING_MAGIC) || (header->version != FRAME_RING_VERSION) || !fits) {
+    TraceLog(LOG_ERROR, "RayAnim: %s is not a compatible frame ring", ring->name);
+    destroyFrameRing(ring);
+    return false;
+  }
+
+  return true;
+}
+
+// Returns an image over the next slot's pixels. With FRAME_RING_BLOCK this waits until the
+// consumer has released enough frames; with FRAME_RING_DROP_OLDEST the oldest frame is reused.
+// A consumer that releases nothing for FRAME_RING_BLOCK_TIMEOUT seconds is assumed gone, and the
+// oldest frame is reused as well.
+Image beginFrameRingWrite(RAFrameRing *ring) {
+  RAFrameRingHeader *header = ring->header;
+  uint64_t sequence = header->writeSequence;
+
+  if (header->policy == FRAME_RING_BLOCK) {
+    struct timespec pause = {0, 500000};
+    uint64_t readSequence = __atomic_load_n(&header->readSequence, __ATOMIC_ACQUIRE);
+    double deadline = getMonotonicTime() + FRAME_RING_BLOCK_TIMEOUT;
+
+    while (sequence - readSequence >= header->slotCount) {
+      if (getMonotonicTime() >= deadline) {
+        TraceLog(LOG_WARNING, "RayAnim: Frame ring %s has no consumer, dropping", ring->name);
+        break;
+      }
+
+      nanosleep(&pause, NULL);
+      uint64_t released = __atomic_load_n(&header->readSequence, __ATOMIC_ACQUIRE);
+      if (released != readSequence) deadline = getMonotonicTime() + FRAME_RING_BLOCK_TIMEOUT;
+      readSequence = released;
+    }
+  }
+
+  RAFrameSlot *slot = getFrameRingSlot(ring, sequence);
+  __atomic_store_n(&slot->sequence, sequence * 2 + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  return (Image){getFrameRingPixels(slot),
+                 (int)header->width,
+                 (int)header->height,
+                 1,
+                 PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+}
+
+void endFrameRingWrite(RAFrameRing *ring, long frame, double time) {
+  RAFrameRingHeader *header = ring->header;
+  uint64_t sequence = header->writeSequence;
+  RAFrameSlot *slot = getFrameRingSlot(ring, sequence);
+
+  slot->frame = frame;
+  slot->time = time;
+  __atomic_store_n(&slot->sequence, sequence * 2 + 2, __ATOMIC_RELEASE);
+  __atomic_store_n(&header->writeSequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+// Returns the pixels of ring frame `sequence` in place, or NULL if it is not written yet or was
+// already overwritten. Check isFrameRingReadValid() after using them to detect an overwrite.
+const unsigned char *readFrameRing(RAFrameRing *ring, uint64_t sequence, RAFrameSlot *info) {
+  if (sequence >= __atomic_load_n(&ring->header->writeSequence, __ATOMIC_ACQUIRE)) return NULL;
+
+  RAFrameSlot *slot = getFrameRingSlot(ring, sequence);
+  if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != sequence * 2 + 2) return NULL;
+
+  if (info != NULL) *info = *slot;
+  return getFrameRingPixels(slot);
+}
+
+bool isFrameRingReadValid(RAFrameRing *ring, uint64_t sequence) {
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  RAFrameSlot *slot = getFrameRingSlot(ring, sequence);
+
+  return __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) == sequence * 2 + 2;
+}
+
+// Tells a blocking producer that every frame up to and including `sequence` has been consumed.
+void releaseFrameRing(RAFrameRing *ring, uint64_t sequence) {
+  __atomic_store_n(&ring->header->readSequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+void destroyFrameRing(RAFrameRing *ring) {
+  trackMemory(MEMORY_FRAMES, -(int64_t)ring->size);
+  munmap(ring->memory, ring->size);
+  close(ring->fd);
+  if (ring->owner) shm_unlink(ring->name);
+
+  ring->memory = NULL;
+  ring->header = NULL;
+}
+
+// ------------------------------------- Frame Sequence --------------------------------------
+
+// An intermediate format for rendered sequences that is cheap to write and to read back. Most
+// frames differ from the previous one only where an animation is active, so only the tiles that
+// changed are stored, XORed with the previous frame so that the unchanged pixels inside them
+// become zero runs. Tiles are compressed in parallel on the shared pool.
+
+DEFINE_VECTOR(FrameSequenceIndex, FrameSequenceKeyframe, keyframes, MEMORY_FRAMES)
+
+#define LZ4_HASH_BITS 12
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MATCH_LIMIT 12
+
+static uint32_t readLz4Word(const unsigned char *data) {
+  uint32_t word;
+  memcpy(&word, data, sizeof(word));
+  return word;
+}
+
+static unsigned char *writeLz4Length(unsigned char *target, int length) {
+  for (; length >= 255; length -= 255) *target++ = 255;
+  *target++ = (unsigned char)length;
+  return target;
+}
+
+static unsigned char *writeLz4Sequence(unsigned char *target,
+                                       const unsigned char *literals,
+                                       int literalCount,
+                                       int offset,
+                                       int matchLength) {
+  unsigned char *token = target++;
+  *token = (unsigned char)((literalCount >= 15 ? 15 : literalCount) << 4);
+  if (literalCount >= 15) target = writeLz4Length(target, literalCount - 15);
+
+  memcpy(target, literals, literalCount);
+  target += literalCount;
+  if (matchLength == 0) return target;
+
+  *target++ = (unsigned char)(offset & 0xFF);
+  *target++ = (unsigned char)(offset >> 8);
+
+  int extra = matchLength - LZ4_MIN_MATCH;
+  *token |= (unsigned char)(extra >= 15 ? 15 : extra);
+  if (extra >= 15) target = writeLz4Length(target, extra - 15);
+
+  return target;
+}
+
+// Writes source as an LZ4 block and returns its size. target needs room for
+// size + size / 255 + 16 bytes, the size of an incompressible block.
+int compressLz4Block(const unsigned char *source, int size, unsigned char *target) {
+  int table[1 << LZ4_HASH_BITS];
+  memset(table, 0xFF, sizeof(table));
+
+  unsigned char *out = target;
+  int anchor = 0;
+  int pos = 0;
+
+  while (pos < size - LZ4_MATCH_LIMIT) {
+    uint32_t word = readLz4Word(source + pos);
+    uint32_t hash = (word * 2654435761u) >> (32 - LZ4_HASH_BITS);
+    int candidate = table[hash];
+    table[hash] = pos;
+
+    if ((candidate < 0) || (pos - candidate > 0xFFFF) ||
+        (readLz4Word(source + candidate) != word)) {
+      pos++;
+      continue;
+    }
+
+    int length = LZ4_MIN_MATCH;
+    while ((pos + length < size - LZ4_LAST_LITERALS) &&
+           (source[candidate + length] == source[pos + length]))
+      length++;
+
+    out = writeLz4Sequence(out, source + anchor, pos - anchor, pos - candidate, length);
+    pos += length;
+    anchor = pos;
+  }
+
+  out = writeLz4Sequence(out, source + anchor, size - anchor, 0, 0);
+  return (int)(out - target);
+}
+
+static bool readLz4Length(const unsigned char **source, const unsigned char *end, int *length) {
+  unsigned char byte;
+
+  do {
+    if (*source >= end) return false;
+    byte = *(*source)++;
+    *length += byte;
+  } while (byte == 255);
+
+  return true;
+}
+
+// Returns false unless source is a valid block that decodes to exactly targetSize bytes.
+bool decompressLz4Block(const unsigned char *source,
+                        int size,
+                        unsigned char *target,
+                        int targetSize) {
+  const unsigned char *end = source + size;
+  unsigned char *out = target;
+  unsigned char *outEnd = target + targetSize;
+
+  while (source < end) {
+    int token = *source++;
+
+    int literalCount = token >> 4;
+    if ((literalCount == 15) && !readLz4Length(&source, end, &literalCount)) return false;
+    if ((literalCount > end - source) || (literalCount > outEnd - out)) return false;
+
+    memcpy(out, source, literalCount);
+    out += literalCount;
+    source += literalCount;
+    if (source == end) break;
+
+    if (end - source < 2) return false;
+    int offset = source[0] | (source[1] << 8);
+    source += 2;
+    if ((offset == 0) || (offset > out - target)) return false;
+
+    int length = token & 15;
+    if ((length == 15) && !readLz4Length(&source, end, &length)) return false;
+    length += LZ4_MIN_MATCH;
+    if (length > outEnd - out) return false;
+
+    // Matches may overlap the bytes they produce, so they are copied forwards one at a time.
+    const unsigned char *match = out - offset;
+    for (int i = 0; i < length; i++) out[i] = match[i];
+    out += length;
+  }
+
+  return out == outEnd;
+}
+
+static int getFrameTileBytes(RAFrameSequence *sequence) {
+  int tileSize = (int)sequence->header.tileSize;
+  return tileSize * tileSize * 4;
+}
+
+static int getFrameTileBound(RAFrameSequence *sequence) {
+  int bytes = getFrameTileBytes(sequence);
+  return bytes + bytes / 255 + 16;
+}
+
+static void allocateFrameSequence(RAFrameSequence *sequence) {
+  RAFrameSequenceHeader *header = &sequence->header;
+  int tileCount;
+
+  sequence->tilesX = (int)((header->width + header->tileSize - 1) / header->tileSize);
+  sequence->tilesY = (int)((header->height + header->tileSize - 1) / header->tileSize);
+  tileCount = sequence->tilesX * sequence->tilesY;
+
+  sequence->pixels = allocateMemory(MEMORY_FRAMES, (size_t)header->width * header->height * 4);
+  sequence->tiles = allocateMemory(MEMORY_FRAMES, tileCount * sizeof(FrameSequenceTile));
+  sequence->tileOffsets = allocateMemory(MEMORY_FRAMES, tileCount * sizeof(size_t));
+  assert((sequence->pixels != NULL) && (sequence->tiles != NULL) &&
+         (sequence->tileOffsets != NULL));
+
+  // The writer compresses every tile into its own slot; the reader grows this as needed.
+  sequence->payloadCapacity = sequence->writing ? (size_t)tileCount * getFrameTileBound(sequence)
+                                                : 0;
+  sequence->payload = allocateMemory(MEMORY_FRAMES, sequence->payloadCapacity);
+  initFrameSequenceIndex(&sequence->index);
+  sequence->frameCount = 0;
+  sequence->currentFrame = -1;
+  sequence->bytesWritten = 0;
+}
+
+bool createFrameSequence(
+    RAFrameSequence *sequence, const char *filename, int width, int height, int keyframeInterval) {
+  assert((width > 0) && (height > 0) && (keyframeInterval > 0));
+
+  sequence->file = fopen(filename, "wb");
+  if (sequence->file == NULL) {
+    TraceLog(LOG_ERROR, "RayAnim: Failed to create frame sequence %s", filename);
+    return false;
+  }
+
+  sequence->writing = true;
+  sequence->header = (RAFrameSequenceHeader){FRAME_SEQUENCE_MAGIC,
+                                             FRAME_SEQUENCE_VERSION,
+                                             (uint32_t)width,
+                                             (uint32_t)height,
+                                             FRAME_SEQUENCE_TILE_SIZE,
+                                             (uint32_t)keyframeInterval};
+  if (fwrite(&sequence->header, sizeof(sequence->header), 1, sequence->file) != 1) {
+    TraceLog(LOG_ERROR, "RayAnim: Failed to write frame sequence %s", filename);
+    fclose(sequence->file);
+    return false;
+  }
+
+  allocateFrameSequence(sequence);
+  sequence->bytesWritten = sizeof(sequence->header);
+  return true;
+}
+
+typedef struct FrameTileContext {
+  RAFrameSequence *sequence;
+  const unsigned char *frame;
+  bool keyframe;
+} FrameTileContext;
+
+// Copies a tile into a packed buffer, or XORs it into one; returns false if the tile is unchanged.
+static bool packFrameTile(
+    RAFrameSequence *sequence, const unsigned char *frame, int tile, bool xor, unsigned char *out) {
+  int tileSize = (int)sequence->header.tileSize;
+  int width = (int)sequence->header.width;
+  int height = (int)sequence->header.height;
+  int x = (tile % sequence->tilesX) * tileSize;
+  int y = (tile / sequence->tilesX) * tileSize;
+  int rowBytes = ((x + tileSize <= width) ? tileSize : width - x) * 4;
+  int rows = (y + tileSize <= height) ? tileSize : height - y;
+  bool changed = false;
+
+  memset(out, 0, getFrameTileBytes(sequence));
+  for (int row = 0; row < rows; row++) {
+    size_t offset = ((size_t)(y + row) * width + x) * 4;
+    const unsigned char *current = frame + offset;
+    const unsigned char *previous = sequence->pixels + offset;
+    unsigned char *packed = out + row * tileSize * 4;
+
+    if (!xor) {
+      memcpy(packed, current, rowBytes);
+      changed = true;
+    } else if (memcmp(current, previous, rowBytes) != 0) {
+      for (int i = 0; i < rowBytes; i++) packed[i] = current[i] ^ previous[i];
+      changed = true;
+    }
+  }
+
+  return changed;
+}
+
+static void compressFrameTiles(void *context, int start, int end) {
+  FrameTileContext *tileContext = (FrameTileContext *)context;
+  RAFrameSequence *sequence = tileContext->sequence;
+  int tileBytes = getFrameTileBytes(sequence);
+  unsigned char packed[tileBytes];
+
+  for (int tile = start; tile < end; tile++) {
+    FrameSequenceTile *info = &sequence->tiles[tile];
+    unsigned char *payload = sequence->payload + (size_t)tile * getFrameTileBound(sequence);
+
+    if (!packFrameTile(sequence, tileContext->frame, tile, !tileContext->keyframe, packed)) {
+      *info = (FrameSequenceTile){FRAME_TILE_SAME, 0};
+      continue;
+    }
+
+    int size = compressLz4Block(packed, tileBytes, payload);
+    if (size < tileBytes) {
+      *info = (FrameSequenceTile){FRAME_TILE_LZ4, (uint32_t)size};
+    } else {
+      memcpy(payload, packed, tileBytes);
+      *info = (FrameSequenceTile){FRAME_TILE_RAW, (uint32_t)tileBytes};
+    }
+  }
+}
+
+static long getFirstSequenceFrame(RAFrameSequence *sequence) {
+  return sequence->index.count > 0 ? (long)sequence->index.keyframes[0].frame : 0;
+}
+
+// Appends image as the given frame, which must follow the previous one. Returns false once a
+// write has failed, after which the file is incomplete.
+bool writeFrameSequence(RAFrameSequence *sequence, long frame, Image image) {
+  assert(sequence->writing);
+  assert((image.width == (int)sequence->header.width) &&
+         (image.height == (int)sequence->header.height));
+  assert((sequence->frameCount == 0) ||
+         (frame == getFirstSequenceFrame(sequence) + sequence->frameCount));
+
+  int tileCount = sequence->tilesX * sequence->tilesY;
+  bool keyframe = sequence->frameCount % sequence->header.keyframeInterval == 0;
+  FrameTileContext context = {sequence, (const unsigned char *)image.data, keyframe};
+
+  parallelFor(getSharedThreadPool(), tileCount, 4, compressFrameTiles, &context);
+
+  RAFrameSequenceFrame record = {(uint64_t)frame, keyframe, 0};
+  for (int tile = 0; tile < tileCount; tile++) record.payloadSize += sequence->tiles[tile].size;
+
+  if (keyframe) {
+    FrameSequenceKeyframe entry = {(uint64_t)frame, sequence->bytesWritten};
+    pushToFrameSequenceIndex(&sequence->index, entry);
+  }
+
+  bool written =
+      (fwrite(&record, sizeof(record), 1, sequence->file) == 1) &&
+      (fwrite(sequence->tiles, sizeof(FrameSequenceTile), tileCount, sequence->file) ==
+       (size_t)tileCount);
+  for (int tile = 0; (tile < tileCount) && written; tile++) {
+    unsigned char *payload = sequence->payload + (size_t)tile * getFrameTileBound(sequence);
+    size_t size = sequence->tiles[tile].size;
+    written = fwrite(payload, 1, size, sequence->file) == size;
+  }
+
+  sequence->bytesWritten +=
+      sizeof(record) + tileCount * sizeof(FrameSequenceTile) + record.payloadSize;
+  memcpy(sequence->pixels, image.data, (size_t)image.width * image.height * 4);
+  sequence->frameCount++;
+  return written && !ferror(sequence->file);
+}
+
+bool openFrameSequence(RAFrameSequence *sequence, const char *filename) {
+  RAFrameSequenceFooter footer;
+
+  sequence->file = fopen(filename, "rb");
+  if (sequence->file == NULL) {
+    TraceLog(LOG_ERROR, "RayAnim: Failed to open frame sequence %s", filename);
+    return false;
+  }
+
+  // Tiles are decoded on the stack, and the frame is held in memory, so both sizes are bounded.
+  RAFrameSequenceHeader *header = &sequence->header;
+  bool valid = (fread(header, sizeof(*header), 1, sequence->file) == 1) &&
+               (header->magic == FRAME_SEQUENCE_MAGIC) &&
+               (header->version == FRAME_SEQUENCE_VERSION) && (header->tileSize > 0) &&
+               (header->tileSize <= FRAME_SEQUENCE_TILE_SIZE) && (header->width > 0) &&
+               (header->width <= FRAME_SEQUENCE_MAX_SIZE) && (header->height > 0) &&
+               (header->height <= FRAME_SEQUENCE_MAX_SIZE) &&
+               (fseeko(sequence->file, -(off_t)sizeof(footer), SEEK_END) == 0) &&
+               (fread(&footer, sizeof(footer), 1, sequence->file) == 1) &&
+               (footer.magic == FRAME_SEQUENCE_MAGIC) &&
+               (footer.version == FRAME_SEQUENCE_VERSION) &&
+               (footer.keyframeCount <= footer.frameCount) && (footer.frameCount <= LONG_MAX) &&
+               (fseeko(sequence->file, (off_t)footer.indexOffset, SEEK_SET) == 0);
+  if (!valid) {
+    TraceLog(LOG_ERROR, "RayAnim: %s is not a frame sequence", filename);
+    fclose(sequence->file);
+    return false;
+  }
+
+  sequence->writing = false;
+  allocateFrameSequence(sequence);
+  sequence->frameCount = (long)footer.frameCount;
+
+  for (uint64_t i = 0; (i < footer.keyframeCount) && valid; i++) {
+    FrameSequenceKeyframe entry;
+    valid = fread(&entry, sizeof(entry), 1, sequence->file) == 1;
+    if (valid) pushToFrameSequenceIndex(&sequence->index, entry);
+  }
+
+  if (!valid) {
+    TraceLog(LOG_ERROR, "RayAnim: Frame sequence %s has a truncated index", filename);
+    closeFrameSequence(sequence);
+  }
+
+  return valid;
+}
+
+static void decompressFrameTiles(void *context, int start, int end) {
+  FrameTileContext *tileContext = (FrameTileContext *)context;
+  RAFrameSequence *sequence = tileContext->sequence;
+  int tileSize = (int)sequence->header.tileSize;
+  int width = (int)sequence->header.width;
+  int height = (int)sequence->header.height;
+  int tileBytes = getFrameTileBytes(sequence);
+  unsigned char unpacked[tileBytes];
+
+  for (int tile = start; tile < end; tile++) {
+    FrameSequenceTile info = sequence->tiles[tile];
+    const unsigned char *payload = sequence->payload + sequence->tileOffsets[tile];
+
+    // Tile types and sizes were checked when the frame was read.
+    if (info.type == FRAME_TILE_SAME) continue;
+    if (info.type == FRAME_TILE_RAW) {
+      memcpy(unpacked, payload, tileBytes);
+    } else if (!decompressLz4Block(payload, (int)info.size, unpacked, tileBytes)) {
+      TraceLog(LOG_WARNING, "RayAnim: Corrupt tile %d in frame %ld", tile, sequence->currentFrame);
+      continue;
+    }
+
+    int x = (tile % sequence->tilesX) * tileSize;
+    int y = (tile / sequence->tilesX) * tileSize;
+    int rowBytes = ((x + tileSize <= width) ? tileSize : width - x) * 4;
+    int rows = (y + tileSize <= height) ? tileSize : height - y;
+
+    for (int row = 0; row < rows; row++) {
+      unsigned char *pixels = sequence->pixels + ((size_t)(y + row) * width + x) * 4;
+      const unsigned char *packed = unpacked + row * tileSize * 4;
+
+      if (tileContext->keyframe) {
+        memcpy(pixels, packed, rowBytes);
+      } else {
+        for (int i = 0; i < rowBytes; i++) pixels[i] ^= packed[i];
+      }
+    }
+  }
+}
+
+static bool isFrameTileValid(RAFrameSequence *sequence, FrameSequenceTile info) {
+  switch (info.type) {
+    case FRAME_TILE_SAME:
+      return info.size == 0;
+    case FRAME_TILE_RAW:
+      return info.size == (uint32_t)getFrameTileBytes(sequence);
+    case FRAME_TILE_LZ4:
+      return info.size <= (uint32_t)getFrameTileBound(sequence);
+    default:
+      return false;
+  }
+}
+
+static bool readNextFrame(RAFrameSequence *sequence) {
+  int tileCount = sequence->tilesX * sequence->tilesY;
+  RAFrameSequenceFrame record;
+
+  if ((fread(&record, sizeof(record), 1, sequence->file) != 1) ||
+      (fread(sequence->tiles, sizeof(FrameSequenceTile), tileCount, sequence->file) !=
+       (size_t)tileCount))
+    return false;
+
+  // Deltas only apply to the frame before them.
+  if (record.frame != (uint64_t)(sequence->currentFrame + 1)) return false;
+
+  // Every tile must have a known type, a raw tile exactly fills one, and together the tiles must
+  // account for the payload, so that decoding never reads past it.
+  uint64_t payloadSize = 0;
+  for (int tile = 0; tile < tileCount; tile++) {
+    if (!isFrameTileValid(sequence, sequence->tiles[tile])) return false;
+    payloadSize += sequence->tiles[tile].size;
+  }
+  if (payloadSize != record.payloadSize) return false;
+
+  if (record.payloadSize > sequence->payloadCapacity) {
+    sequence->payload =
+        reallocateMemory(MEMORY_FRAMES, sequence->payload, record.payloadSize);
+    sequence->payloadCapacity = record.payloadSize;
+    assert(sequence->payload != NULL);
+  }
+
+  if (fread(sequence->payload, 1, record.payloadSize, sequence->file) != record.payloadSize)
+    return false;
+
+  size_t offset = 0;
+  for (int tile = 0; tile < tileCount; tile++) {
+    sequence->tileOffsets[tile] = offset;
+    offset += sequence->tiles[tile].size;
+  }
+
+  sequence->currentFrame = (long)record.frame;
+  FrameTileContext context = {sequence, NULL, record.keyframe != 0};
+  parallelFor(getSharedThreadPool(), tileCount, 4, decompressFrameTiles, &context);
+  return true;
+}
+
+// Decodes the given frame into target, which needs the sequence's size and an RGBA8 buffer.
+// Reading forwards continues from the last frame read; other frames are reached by seeking to
+// the closest keyframe before them.
+bool readFrameSequence(RAFrameSequence *sequence, long frame, Image *target) {
+  assert(!sequence->writing);
+  assert((target->width == (int)sequence->header.width) &&
+         (target->height == (int)sequence->header.height));
+  if (sequence->index.count == 0) return false;
+
+  long first = getFirstSequenceFrame(sequence);
+  if ((frame < first) || (frame - first >= sequence->frameCount)) return false;
+
+  int low = 0;
+  int high = sequence->index.count - 1;
+  while (low < high) {
+    int mid = (low + high + 1) / 2;
+    if ((long)sequence->index.keyframes[mid].frame <= frame) {
+      low = mid;
+    } else {
+      high = mid - 1;
+    }
+  }
+
+  FrameSequenceKeyframe keyframe = sequence->index.keyframes[low];
+  bool continuing =
+      (sequence->currentFrame < frame) && (sequence->currentFrame >= (long)keyframe.frame);
+
+  if (!continuing) {
+    if (fseeko(sequence->file, (off_t)keyframe.offset, SEEK_SET) != 0) return false;
+    sequence->currentFrame = (long)keyframe.frame - 1;
+  }
+
+  while (sequence->currentFrame < frame)
+    if (!readNextFrame(sequence)) return false;
+
+  memcpy(target->data, sequence->pixels, (size_t)target->width * target->height * 4);
+  return true;
+}
+
+// Finishes a written sequence with its keyframe index, and releases either kind. Returns false
+// if any part of a written sequence failed to reach the file.
+bool closeFrameSequence(RAFrameSequence *sequence) {
+  bool written = true;
+
+  if (sequence->writing) {
+    RAFrameSequenceFooter footer = {sequence->bytesWritten,
+                                    (uint64_t)sequence->index.count,
+                                    (uint64_t)sequence->frameCount,
+                                    FRAME_SEQUENCE_MAGIC,
+                                    FRAME_SEQUENCE_VERSION};
+    written = !ferror(sequence->file) &&
+              (fwrite(sequence->index.keyframes,
+                      sizeof(FrameSequenceKeyframe),
+                      sequence->index.count,
+                      sequence->file) == (size_t)sequence->index.count) &&
+              (fwrite(&footer, sizeof(footer), 1, sequence->file) == 1);
+    if (!written) TraceLog(LOG_ERROR, "RayAnim: Failed to finish the frame sequence");
+
+    double raw = (double)sequence->frameCount * sequence->header.width *
+                 sequence->header.height * 4;
+    TraceLog(LOG_INFO,
+             "RayAnim: Wrote %ld frames (%.1f MB, %.1f%% of raw)",
+             sequence->frameCount,
+             sequence->bytesWritten / (1024.0 * 1024.0),
+             raw > 0 ? 100.0 * sequence->bytesWritten / raw : 0.0);
+  }
+
+  // Buffered data is only flushed here, so a full disk may show up no earlier.
+  written = (fclose(sequence->file) == 0) && written;
+  sequence->file = NULL;
+  releaseMemory(sequence->pixels);
+  releaseMemory(sequence->tiles);
+  releaseMemory(sequence->tileOffsets);
+  releaseMemory(sequence->payload);
+  destroyFrameSequenceIndex(&sequence->index);
+  return written;
+}
+
+// -------------------------------------- Render Server --------------------------------------
+
+// A client connects, writes one request line and gets one reply line once every frame of the
+// job has been written: "ok <frames> <queued> <setup> <render> <total>" with times in
+// milliseconds, or "error <reason>".
+//
+// All jobs share this process's window, thread pool and loaded assets, so textures and font
+// atlases stay warm from one job to the next. Jobs take turns rendering a frame on this thread
+// while the pool encodes, at most maxJobs are admitted, and a job only starts while the tracked
+// memory is below memoryBudget. When nothing is rendering and the budget is still exceeded, the
+// asset caches are dropped; a job that would still start over budget stays queued.
+
+typedef enum RenderJobState {
+  RENDER_JOB_FREE,
+  RENDER_JOB_READING,
+  RENDER_JOB_QUEUED,
+  RENDER_JOB_RENDERING
+} RenderJobState;
+
+struct RenderJob {
+  RenderJobState state;
+  int fd;
+  char request[RENDER_SERVER_REQUEST_SIZE];
+  int requestLength;
+  Scene scene;
+  void *data;
+  RecordSession session;
+  double connectTime;
+  RenderJobTiming timing;
+};
+
+static double getMonotonicTime(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+void initRenderServer(RARenderServer *server,
+                      const char *socketPath,
+                      void *(*buildJob)(Scene *, const char *, void *),
+                      void (*releaseJob)(void *, void *),
+                      void *context) {
+  server->socketPath = socketPath;
+  server->maxJobs = RENDER_SERVER_MAX_JOBS;
+  server->memoryBudget = RENDER_SERVER_MEMORY_BUDGET;
+  server->buildJob = buildJob;
+  server->releaseJob = releaseJob;
+  server->context = context;
+  server->listenFd = -1;
+  server->jobs = NULL;
+  server->stopping = false;
+}
+
+static void finishRenderJob(RenderJob *job, const char *reply) {
+  send(job->fd, reply, strlen(reply), MSG_NOSIGNAL);
+  close(job->fd);
+  job->state = RENDER_JOB_FREE;
+}
+
+static void acceptRenderJobs(RARenderServer *server) {
+  for (int i = 0; i < server->maxJobs; i++) {
+    RenderJob *job = &server->jobs[i];
+    if (job->state != RENDER_JOB_FREE) continue;
+
+    int fd = accept(server->listenFd, NULL, NULL);
+    if (fd < 0) return;
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    job->state = RENDER_JOB_READING;
+    job->fd = fd;
+    job->requestLength = 0;
+    job->connectTime = getMonotonicTime();
+    job->timing = (RenderJobTiming){0};
+  }
+}
+
+static void readRenderJobs(RARenderServer *server) {
+  for (int i = 0; i < server->maxJobs; i++) {
+    RenderJob *job = &server->jobs[i];
+    if (job->state != RENDER_JOB_READING) continue;
+
+    int capacity = RENDER_SERVER_REQUEST_SIZE - 1 - job->requestLength;
+    ssize_t received = recv(job->fd, job->request + job->requestLength, capacity, 0);
+    if ((received < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) continue;
+
+    if (received > 0) job->requestLength += received;
+    job->request[job->requestLength] = '\0';
+
+    char *newline = strchr(job->request, '\n');
+    if (newline != NULL) *newline = '\0';
+
+    bool complete = (newline != NULL) || (job->requestLength == RENDER_SERVER_REQUEST_SIZE - 1);
+    if ((received <= 0) && !complete) {
+      if (job->requestLength == 0) {
+        close(job->fd);
+        job->state = RENDER_JOB_FREE;
+        continue;
+      }
+      complete = true;
+    }
+
+    if (complete) job->state = RENDER_JOB_QUEUED;
+  }
+}
+
+static int countRenderJobs(RARenderServer *server, RenderJobState state) {
+  int count = 0;
+  for (int i = 0; i < server->maxJobs; i++)
+    if (server->jobs[i].state == state) count++;
+
+  return count;
+}
+
+static void startRenderJobs(RARenderServer *server) {
+  for (int i = 0; i < server->maxJobs; i++) {
+    RenderJob *job = &server->jobs[i];
+    if (job->state != RENDER_JOB_QUEUED) continue;
+
+    // Jobs cannot unload assets they still use, so the slots are freed between jobs, well
+    // before a single job could run out of them.
+    bool overBudget = getMemoryStats().totalCurrent >= server->memoryBudget;
+    bool slotsLow = (textureCount > MAX_LOADED_ASSETS / 2) || (fontCount > MAX_LOADED_ASSETS / 2);
+    if (overBudget || slotsLow) {
+      if (countRenderJobs(server, RENDER_JOB_RENDERING) > 0) return;
+
+      if (IsWindowReady() && ((textureCount > 0) || (fontCount > 1))) {
+        TraceLog(LOG_INFO, "RayAnim: Render server low on memory or asset slots, unloading assets");
+        unloadAssets();
+      }
+      if (getMemoryStats().totalCurrent >= server->memoryBudget) return;
+    }
+
+    double start = getMonotonicTime();
+    job->timing.queued = start - job->connectTime;
+    job->data = server->buildJob(&job->scene, job->request, server->context);
+    if (job->data == NULL) {
+      finishRenderJob(job, "error rejected\n");
+      continue;
+    }
+
+    beginRecordSession(&job->session, &job->scene);
+    job->timing.setup = getMonotonicTime() - start;
+    job->state = RENDER_JOB_RENDERING;
+  }
+}
+
+// Renders one frame of every running job. Returns false if no job is running.
+static bool stepRenderJobs(RARenderServer *server) {
+  bool rendered = false;
+
+  for (int i = 0; i < server->maxJobs; i++) {
+    RenderJob *job = &server->jobs[i];
+    if (job->state != RENDER_JOB_RENDERING) continue;
+
+    double start = getMonotonicTime();
+    bool running = stepRecordSession(&job->session);
+    job->timing.render += getMonotonicTime() - start;
+    rendered = true;
+    if (running) continue;
+
+    endRecordSession(&job->session);
+    job->timing.total = getMonotonicTime() - job->connectTime;
+
+    char reply[128];
+    snprintf(reply,
+             sizeof(reply),
+             "ok %ld %.2f %.2f %.2f %.2f\n",
+             job->scene.frame + 1,
+             job->timing.queued * 1000.0,
+             job->timing.setup * 1000.0,
+             job->timing.render * 1000.0,
+             job->timing.total * 1000.0);
+    TraceLog(LOG_INFO, "RayAnim: Job \"%s\" done: %s", job->request, reply);
+
+    releaseScene(&job->scene);
+    if (server->releaseJob != NULL) server->releaseJob(job->data, server->context);
+    finishRenderJob(job, reply);
+  }
+
+  return rendered;
+}
+
+// Sleeps until a client connects or sends data, or a queued job may be able to start.
+static void waitForRenderServer(RARenderServer *server) {
+  struct pollfd fds[server->maxJobs + 1];
+  nfds_t count = 0;
+  bool freeSlot = countRenderJobs(server, RENDER_JOB_FREE) > 0;
+
+  if (freeSlot && !__atomic_load_n(&server->stopping, __ATOMIC_ACQUIRE))
+    fds[count++] = (struct pollfd){server->listenFd, POLLIN, 0};
+
+  for (int i = 0; i < server->maxJobs; i++)
+    if (server->jobs[i].state == RENDER_JOB_READING)
+      fds[count++] = (struct pollfd){server->jobs[i].fd, POLLIN, 0};
+
+  poll(fds, count, countRenderJobs(server, RENDER_JOB_QUEUED) > 0 ? 10 : 100);
+}
+
+// Serves jobs until stopRenderServer() is called; jobs already rendering are finished first.
+bool runRenderServer(RARenderServer *server) {
+  assert((server->maxJobs > 0) && (server->buildJob != NULL));
+
+  struct sockaddr_un address = {0};
+  address.sun_family = AF_UNIX;
+  if (strlen(server->socketPath) >= sizeof(address.sun_path)) {
+    TraceLog(LOG_WARNING, "RayAnim: Socket path %s is too long", server->socketPath);
+    return false;
+  }
+  strcpy(address.sun_path, server->socketPath);
+
+  unlink(server->socketPath);
+  server->listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if ((server->listenFd < 0) ||
+      (bind(server->listenFd, (struct sockaddr *)&address, sizeof(address)) < 0) ||
+      (listen(server->listenFd, SOMAXCONN) < 0)) {
+    TraceLog(LOG_WARNING, "RayAnim: Failed to listen on %s", server->socketPath);
+    if (server->listenFd >= 0) close(server->listenFd);
+    server->listenFd = -1;
+    return false;
+  }
+  fcntl(server->listenFd, F_SETFL, fcntl(server->listenFd, F_GETFL) | O_NONBLOCK);
+
+  server->jobs = allocateMemory(MEMORY_SCENE, server->maxJobs * sizeof(RenderJob));
+  assert(server->jobs != NULL);
+  for (int i = 0; i < server->maxJobs; i++) server->jobs[i].state = RENDER_JOB_FREE;
+
+  TraceLog(LOG_INFO, "RayAnim: Render server listening on %s", server->socketPath);
+
+  for (;;) {
+    bool stopping = __atomic_load_n(&server->stopping, __ATOMIC_ACQUIRE);
+    if (stopping && (countRenderJobs(server, RENDER_JOB_RENDERING) == 0)) break;
+
+    if (!stopping) {
+      acceptRenderJobs(server);
+      readRenderJobs(server);
+      startRenderJobs(server);
+    }
+
+    if (!stepRenderJobs(server)) waitForRenderServer(server);
+  }
+
+  for (int i = 0; i < server->maxJobs; i++)
+    if (server->jobs[i].state != RENDER_JOB_FREE)
+      finishRenderJob(&server->jobs[i], "error stopping\n");
+
+  close(server->listenFd);
+  unlink(server->socketPath);
+  releaseMemory(server->jobs);
+  server->listenFd = -1;
+  server->jobs = NULL;
+
+  destroyBatch();
+  destroySharedThreadPool();
+  if (IsWindowReady()) {
+    unloadAssets();
+    CloseWindow();
+  }
+
+  return true;
+}
+
+// Safe to call from a signal handler or from buildJob().
+void stopRenderServer(RARenderServer *server) {
+  __atomic_store_n(&server->stopping, true, __ATOMIC_RELEASE);
+}
+
+// -------------------------------------- Scene Template -------------------------------------
+
+// Objects and animations are added to the template's scene as usual, and parameters are added
+// before compileSceneTemplate().
+void initSceneTemplate(
+    RASceneTemplate *sceneTemplate, const char *title, int width, int height, Color color) {
+  initScene(&sceneTemplate->scene, title, width, height, color);
+  initTemplateParams(&sceneTemplate->params);
+  initTemplateObjectStates(&sceneTemplate->states);
+  sceneTemplate->bound = false;
+}
+
+// The field's current value becomes the parameter's default.
+int addTemplateParam(RASceneTemplate *sceneTemplate,
+                     const char *name,
+                     TemplateParamType type,
+                     RAObject *object,
+                     void *field) {
+  assert(!sceneTemplate->scene.compiled && (type != TEMPLATE_PARAM_TEXT));
+
+  TemplateParam param = {name, type, object, field, {0}, 0.0f};
+  switch (type) {
+    case TEMPLATE_PARAM_COLOR:
+      param.defaultValue.color = *(Color *)field;
+      break;
+    case TEMPLATE_PARAM_FLOAT:
+      param.defaultValue.number = *(float *)field;
+      break;
+    case TEMPLATE_PARAM_VECTOR2:
+      param.defaultValue.vector = *(Vector2 *)field;
+      break;
+    case TEMPLATE_PARAM_TEXT:
+      break;
+  }
+
+  pushToTemplateParams(&sceneTemplate->params, param);
+  return sceneTemplate->params.count - 1;
+}
+
+int addTemplateTextParam(RASceneTemplate *sceneTemplate, const char *name, RAText *text) {
+  assert(!sceneTemplate->scene.compiled && (strlen(text->fullText) > 0));
+
+  TemplateParam param = {name, TEMPLATE_PARAM_TEXT, &text->base, &text->fullText, {0}, 0.0f};
+  param.defaultValue.text = text->fullText;
+  param.revealDuration = text->charRevealTime * strlen(text->fullText);
+
+  pushToTemplateParams(&sceneTemplate->params, param);
+  return sceneTemplate->params.count - 1;
+}
+
+bool compileSceneTemplate(RASceneTemplate *sceneTemplate) {
+  ScenePlan *plan = &sceneTemplate->scene.plan;
+  assert(sceneTemplate->scene.time == 0.0);
+
+  shrinkTemplateParams(&sceneTemplate->params);
+  if (!compileScene(&sceneTemplate->scene)) return false;
+
+  for (int i = 0; i < plan->steps.count; i++) {
+    RAObject *obj = plan->steps.steps[i].anim->object;
+    if (obj == NULL) continue;
+
+    TemplateObjectState state = {obj, obj->position, obj->color, obj->opacity};
+    pushToTemplateObjectStates(&sceneTemplate->states, state);
+  }
+  shrinkTemplateObjectStates(&sceneTemplate->states);
+
+  return true;
+}
+
+void destroySceneTemplate(RASceneTemplate *sceneTemplate) {
+  assert(!sceneTemplate->bound);
+  destroyTemplateParams(&sceneTemplate->params);
+  destroyTemplateObjectStates(&sceneTemplate->states);
+  destroyScene(&sceneTemplate->scene);
+}
+
+// A NULL outputDir disables writing frame files, as with setSceneRecordOutput().
+void initSceneInstance(RASceneInstance *instance,
+                       RASceneTemplate *sceneTemplate,
+                       const char *outputDir) {
+  instance->sceneTemplate = sceneTemplate;
+  initTemplateOverrides(&instance->overrides);
+  instance->outputDir = outputDir;
+}
+
+void setInstanceParam(RASceneInstance *instance, const char *name, TemplateValue value) {
+  TemplateParams *params = &instance->sceneTemplate->params;
+  int param = 0;
+  while ((param < params->count) && (strcmp(params->params[param].name, name) != 0)) param++;
+  assert(param < params->count);
+
+  for (int i = 0; i < instance->overrides.count; i++) {
+    if (instance->overrides.overrides[i].param == param) {
+      instance->overrides.overrides[i].value = value;
+      return;
+    }
+  }
+
+  pushToTemplateOverrides(&instance->overrides, (TemplateOverride){param, value});
+}
+
+void setInstanceText(RASceneInstance *instance, const char *name, char *text) {
+  setInstanceParam(instance, name, (TemplateValue){.text = text});
+}
+
+void setInstanceColor(RASceneInstance *instance, const char *name, Color color) {
+  setInstanceParam(instance, name, (TemplateValue){.color = color});
+}
+
+static void applyTemplateParam(TemplateParam *param, TemplateValue value) {
+  switch (param->type) {
+    case TEMPLATE_PARAM_TEXT: {
+      RAText *text = (RAText *)param->object;
+      size_t length = strlen(value.text);
+      text->fullText = value.text;
+      text->charRevealTime = length > 0 ? param->revealDuration / length : param->revealDuration;
+      break;
+    }
+    case TEMPLATE_PARAM_COLOR:
+      *(Color *)param->field = value.color;
+      break;
+    case TEMPLATE_PARAM_FLOAT:
+      *(float *)param->field = value.number;
+      break;
+    case TEMPLATE_PARAM_VECTOR2:
+      *(Vector2 *)param->field = value.vector;
+      break;
+  }
+
+  markRAObjectDirty(param->object);
+}
+
+// Entries reset their animations and show their objects when they start, so emptying the scene
+// and restarting the plan replays it from the beginning.
+static void rewindScene(Scene *scene) {
+  for (int i = 0; i < scene->objects.count; i++)
+    removeFromSpatialIndex(&scene->spatialIndex, scene->objects.objects[i]);
+  clearRAObjects(&scene->objects);
+
+  scene->currentAnimation = NULL;
+  scene->animationStartTime = 0.0;
+  scene->frame = 0;
+  scene->time = 0.0;
+  scene->plan.currentEntry = 0;
+}
+
+// The template stays bound to the instance, e.g. for the whole of a render server job, until
+// unbindSceneInstance() is called.
+Scene *bindSceneInstance(RASceneInstance *instance) {
+  RASceneTemplate *sceneTemplate = instance->sceneTemplate;
+  TemplateParams *params = &sceneTemplate->params;
+  assert(sceneTemplate->scene.compiled && !sceneTemplate->bound);
+  sceneTemplate->bound = true;
+
+  rewindScene(&sceneTemplate->scene);
+  sceneTemplate->scene.outputDir = instance->outputDir;
+
+  for (int i = 0; i < sceneTemplate->states.count; i++) {
+    TemplateObjectState *state = &sceneTemplate->states.states[i];
+    state->object->position = state->position;
+    state->object->color = state->color;
+    state->object->opacity = state->opacity;
+    markRAObjectDirty(state->object);
+  }
+
+  for (int i = 0; i < params->count; i++)
+    applyTemplateParam(&params->params[i], params->params[i].defaultValue);
+  for (int i = 0; i < instance->overrides.count; i++) {
+    TemplateOverride *override = &instance->overrides.overrides[i];
+    applyTemplateParam(&params->params[override->param], override->value);
+  }
+
+  return &sceneTemplate->scene;
+}
+
+void unbindSceneInstance(RASceneInstance *instance) {
+  assert(instance->sceneTemplate->bound);
+  instance->sceneTemplate->bound = false;
+}
+
+// Records to the instance's output directory and the template scene's other outputs and, unlike
+// recordScene(), keeps the window and the loaded assets for the next instance.
+void recordSceneInstance(RASceneInstance *instance) {
+  RecordSession session;
+
+  beginRecordSession(&session, bindSceneInstance(instance));
+  while (stepRecordSession(&session)) continue;
+  endRecordSession(&session);
+  unbindSceneInstance(instance);
+}
+
+void destroySceneInstance(RASceneInstance *instance) {
+  destroyTemplateOverrides(&instance->overrides);
+  instance->sceneTemplate = NULL;
+}
+
+// -------------------------------------- Spatial Index --------------------------------------
+
+// A uniform grid over the scene's viewport. Objects are filed under every cell their bounds
+// touch, clamped to the grid. markRAObjectDirty() queues an object's root on the dirty list and
+// only queued entries are refiled, so a lookup costs the cells it touches.
+
+static void removeFromSpatialCell(SpatialCell *cell, int entry) {
+  int *entries = getSpatialCellItems(cell);
+
+  for (int i = 0; i < cell->count; i++) {
+    if (entries[i] == entry) {
+      swapRemoveFromSpatialCell(cell, i);
+      return;
+    }
+  }
+}
+
+static int clampToGrid(float value, float cellSize, int cellCount) {
+  int cell = (int)floorf(value / cellSize);
+  return cell < 0 ? 0 : (cell >= cellCount ? cellCount - 1 : cell);
+}
+
+static void fileSpatialEntry(SpatialIndex *index, int slot) {
+  SpatialEntry *entry = &index->entries.entries[slot];
+  Rectangle bounds = entry->object->bounds(entry->object);
+
+  entry->revision = entry->object->revision;
+  entry->unbounded = isBoundsUnbounded(bounds);
+  entry->bounds = bounds;
+
+  if (entry->unbounded) {
+    pushToSpatialCell(&index->unbounded, slot);
+    return;
+  }
+
+  entry->minColumn = clampToGrid(bounds.x, index->cellSize, index->columns);
+  entry->minRow = clampToGrid(bounds.y, index->cellSize, index->rows);
+  entry->maxColumn = clampToGrid(bounds.x + bounds.width, index->cellSize, index->columns);
+  entry->maxRow = clampToGrid(bounds.y + bounds.height, index->cellSize, index->rows);
+
+  for (int row = entry->minRow; row <= entry->maxRow; row++)
+    for (int column = entry->minColumn; column <= entry->maxColumn; column++)
+      pushToSpatialCell(&index->cells[row * index->columns + column], slot);
+}
+
+static void unfileSpatialEntry(SpatialIndex *index, int slot) {
+  SpatialEntry *entry = &index->entries.entries[slot];
+
+  if (entry->unbounded) {
+    removeFromSpatialCell(&index->unbounded, slot);
+    return;
+  }
+
+  for (int row = entry->minRow; row <= entry->maxRow; row++)
+    for (int column = entry->minColumn; column <= entry->maxColumn; column++)
+      removeFromSpatialCell(&index->cells[row * index->columns + column], slot);
+}
+
+void initSpatialIndex(SpatialIndex *index, int width, int height, float cellSize) {
+  index->cellSize = cellSize;
+  index->columns = (int)ceilf(width / cellSize);
+  index->rows = (int)ceilf(height / cellSize);
+  index->cells = allocateMemory(MEMORY_SCENE, index->columns * index->rows * sizeof(SpatialCell));
+  assert(index->cells != NULL);
+  memset(index->cells, 0, index->columns * index->rows * sizeof(SpatialCell));
+
+  initSpatialCell(&index->unbounded);
+  initSpatialCell(&index->freeSlots);
+  initSpatialEntries(&index->entries);
+  initSpatialSlots(&index->dirtySlots);
+  index->nextOrder = 0;
+  index->stamp = 0;
+
+  initSpatialSlots(&index->resultIds);
+  initRAObjects(&index->results);
+}
+
+void insertIntoSpatialIndex(SpatialIndex *index, RAObject *obj) {
+  assert(obj->_indexSlot == -1);
+
+  int slot;
+  bool queued = false;
+  if (index->freeSlots.count > 0) {
+    slot = popFromSpatialCell(&index->freeSlots);
+    queued = index->entries.entries[slot].queued;
+  } else {
+    slot = index->entries.count;
+    pushToSpatialEntries(&index->entries, (SpatialEntry){0});
+    // Slots are queued from pool threads, so the dirty list is sized up front.
+    reserveSpatialSlots(&index->dirtySlots, index->entries.capacity);
+  }
+
+  // A reused slot may still be on the dirty list, where it must not appear twice.
+  SpatialEntry *entry = &index->entries.entries[slot];
+  *entry = (SpatialEntry){0};
+  entry->object = obj;
+  entry->order = index->nextOrder++;
+  entry->queued = queued;
+  obj->_index = index;
+  obj->_indexSlot = slot;
+  fileSpatialEntry(index, slot);
+}
+
+void removeFromSpatialIndex(SpatialIndex *index, RAObject *obj) {
+  int slot = obj->_indexSlot;
+  if (slot == -1) return;
+
+  unfileSpatialEntry(index, slot);
+  index->entries.entries[slot].object = NULL;
+  pushToSpatialCell(&index->freeSlots, slot);
+  obj->_index = NULL;
+  obj->_indexSlot = -1;
+}
+
+// Animations may mark objects from pool threads. Each slot is queued at most once, so the list
+// never outgrows the entries.
+static void queueSpatialEntry(SpatialIndex *index, int slot) {
+  if (__atomic_exchange_n(&index->entries.entries[slot].queued, true, __ATOMIC_ACQ_REL)) return;
+
+  int position = __atomic_fetch_add(&index->dirtySlots.count, 1, __ATOMIC_ACQ_REL);
+  index->dirtySlots.slots[position] = slot;
+}
+
+static void refileSpatialEntry(SpatialIndex *index, int slot) {
+  unfileSpatialEntry(index, slot);
+  fileSpatialEntry(index, slot);
+}
+
+void updateSpatialIndex(SpatialIndex *index) {
+  for (int i = 0; i < index->dirtySlots.count; i++) {
+    int slot = index->dirtySlots.slots[i];
+    SpatialEntry *entry = &index->entries.entries[slot];
+    entry->queued = false;
+
+    if ((entry->object != NULL) && (entry->revision != entry->object->revision))
+      refileSpatialEntry(index, slot);
+  }
+
+  clearSpatialSlots(&index->dirtySlots);
+}
+
+static SpatialIndex *sortingIndex;
+
+static int compareSpatialOrder(const void *a, const void *b) {
+  unsigned int orderA = sortingIndex->entries.entries[*(const int *)a].order;
+  unsigned int orderB = sortingIndex->entries.entries[*(const int *)b].order;
+  return (orderA > orderB) - (orderA < orderB);
+}
+
+static void collectSpatialCell(SpatialIndex *index, SpatialCell *cell) {
+  int *slots = getSpatialCellItems(cell);
+
+  for (int i = 0; i < cell->count; i++) {
+    SpatialEntry *entry = &index->entries.entries[slots[i]];
+    if (entry->stamp == index->stamp) continue;
+
+    entry->stamp = index->stamp;
+    pushToSpatialSlots(&index->resultIds, slots[i]);
+  }
+}
+
+// Returns the objects whose cells overlap the area, in the order they were added to the scene.
+// The result buffer belongs to the index and is reused by the next query.
+int querySpatialIndex(SpatialIndex *index, Rectangle area, RAObject ***results) {
+  index->stamp++;
+  clearSpatialSlots(&index->resultIds);
+  clearRAObjects(&index->results);
+
+  collectSpatialCell(index, &index->unbounded);
+
+  int minColumn = clampToGrid(area.x, index->cellSize, index->columns);
+  int minRow = clampToGrid(area.y, index->cellSize, index->rows);
+  int maxColumn = clampToGrid(area.x + area.width, index->cellSize, index->columns);
+  int maxRow = clampToGrid(area.y + area.height, index->cellSize, index->rows);
+
+  for (int row = minRow; row <= maxRow; row++)
+    for (int column = minColumn; column <= maxColumn; column++)
+      collectSpatialCell(index, &index->cells[row * index->columns + column]);
+
+  int *slots = index->resultIds.slots;
+  int count = index->resultIds.count;
+  sortingIndex = index;
+  if (count > 1) qsort(slots, count, sizeof(int), compareSpatialOrder);
+
+  for (int i = 0; i < count; i++)
+    pushToRAObjects(&index->results, index->entries.entries[slots[i]].object);
+
+  *results = index->results.objects;
+  return count;
+}
+
+// Keeps the objects, all of which must be in the index, whose bounds overlap the area, in their
+// given order. The result buffer is the one querySpatialIndex() uses.
+int filterSpatialIndex(
+    SpatialIndex *index, RAObject **objects, int count, Rectangle area, RAObject ***results) {
+  clearRAObjects(&index->results);
+  reserveRAObjects(&index->results, count);
+
+  for (int i = 0; i < count; i++) {
+    SpatialEntry *entry = &index->entries.entries[objects[i]->_indexSlot];
+    Rectangle bounds = entry->bounds;
+
+    if (entry->unbounded ||
+        ((bounds.x < area.x + area.width) && (bounds.y < area.y + area.height) &&
+         (bounds.x + bounds.width > area.x) && (bounds.y + bounds.height > area.y)))
+      pushToRAObjects(&index->results, objects[i]);
+  }
+
+  *results = index->results.objects;
+  return index->results.count;
+}
+
+void destroySpatialIndex(SpatialIndex *index) {
+  for (int i = 0; i < index->columns * index->rows; i++) destroySpatialCell(&index->cells[i]);
+
+  for (int slot = 0; slot < index->entries.count; slot++) {
+    RAObject *obj = index->entries.entries[slot].object;
+    if (obj == NULL) continue;
+
+    obj->_index = NULL;
+    obj->_indexSlot = -1;
+  }
+
+  releaseMemory(index->cells);
+  destroySpatialCell(&index->unbounded);
+  destroySpatialCell(&index->freeSlots);
+  destroySpatialEntries(&index->entries);
+  destroySpatialSlots(&index->dirtySlots);
+  destroySpatialSlots(&index->resultIds);
+  destroyRAObjects(&index->results);
+}
+
+// ---------------------------------------- Batching -----------------------------------------
+
+// Triangles from consecutive batch-aware renderers are gathered here and submitted together.
+// Anything drawn directly through raylib flushes first, so painter's order is preserved.
+static struct {
+  DrawVertices vertices;
+  DrawColors colors;
+} batch;
+
+// Commands emitted outside a recording pass through this list and are drawn immediately.
+static DisplayList immediateList;
+
+// Renderers reserve room, write vertices and colors past the end, then commit what they wrote.
+static void reserveBatch(int vertexCount) {
+  int count = batch.vertices.count + vertexCount;
+  if (count <= batch.vertices.capacity) return;
+
+  int capacity = batch.vertices.capacity == 0 ? 3 * 1024 : batch.vertices.capacity;
+  while (capacity < count) capacity *= 2;
+
+  reserveDrawVertices(&batch.vertices, capacity);
+  reserveDrawColors(&batch.colors, capacity);
+}
+
+static Vector2 *getBatchVertices(void) {
+  return batch.vertices.vertices + batch.vertices.count;
+}
+
+static Color *getBatchColors(void) {
+  return batch.colors.colors + batch.colors.count;
+}
+
+static void commitBatch(int vertexCount) {
+  batch.vertices.count += vertexCount;
+  batch.colors.count += vertexCount;
+}
+
+// raylib culls clockwise triangles, so the winding is fixed here instead of at every call site.
+static void orientTriangle(Vector2 *vertices) {
+  Vector2 v1 = vertices[0];
+  Vector2 v2 = vertices[1];
+  Vector2 v3 = vertices[2];
+
+  float cross = (v2.x - v1.x) * (v3.y - v1.y) - (v2.y - v1.y) * (v3.x - v1.x);
+  if (cross > 0) {
+    vertices[1] = v3;
+    vertices[2] = v2;
+  }
+}
+
+void batchTriangle(Vector2 v1, Vector2 v2, Vector2 v3, Color color) {
+  if (color.a == 0) return;
+
+  reserveBatch(3);
+
+  Vector2 *vertices = getBatchVertices();
+  Color *colors = getBatchColors();
+  vertices[0] = v1;
+  vertices[1] = v2;
+  vertices[2] = v3;
+  orientTriangle(vertices);
+  colors[0] = colors[1] = colors[2] = color;
+  commitBatch(3);
+}
+
+void batchRectangle(Rectangle rect, Color color) {
+  if ((rect.width <= 0) || (rect.height <= 0)) return;
+
+  Vector2 topLeft = {rect.x, rect.y};
+  Vector2 topRight = {rect.x + rect.width, rect.y};
+  Vector2 bottomLeft = {rect.x, rect.y + rect.height};
+  Vector2 bottomRight = {rect.x + rect.width, rect.y + rect.height};
+
+  batchTriangle(topLeft, bottomLeft, bottomRight, color);
+  batchTriangle(topLeft, bottomRight, topRight, color);
+}
+
+static void drawTriangles(const Vector2 *vertices, const Color *colors, int vertexCount) {
+  for (int start = 0; start < vertexCount; start += BATCH_CHUNK_VERTICES) {
+    int end = start + BATCH_CHUNK_VERTICES < vertexCount ? start + BATCH_CHUNK_VERTICES
+                                                         : vertexCount;
+
+    rlCheckRenderBatchLimit(end - start);
+    rlBegin(RL_TRIANGLES);
+    for (int i = start; i < end; i++) {
+      Color color = colors[i];
+      rlColor4ub(color.r, color.g, color.b, color.a);
+      rlVertex2f(vertices[i].x, vertices[i].y);
+    }
+    rlEnd();
+  }
+}
+
+void flushBatch(void) {
+  if (batch.vertices.count > 0)
+    emitTriangles(batch.vertices.vertices, batch.colors.colors, batch.vertices.count);
+
+  clearDrawVertices(&batch.vertices);
+  clearDrawColors(&batch.colors);
+}
+
+void destroyBatch(void) {
+  destroyDrawVertices(&batch.vertices);
+  destroyDrawColors(&batch.colors);
+  destroyDisplayList(&immediateList);
+}
+
+bool isBatchedRenderer(void (*render)(void *)) {
+  return (render == renderDefaultRectangle) || (render == renderFillInnerRectangle) ||
+         (render == renderDefaultParticles) || (render == renderDefaultPath) ||
+         (render == renderDefaultMorph) || (render == renderEmptyRAObject);
+}
+
+static DisplayList *recordingList = NULL;
+
+void renderRAObject(RAObject *obj) {
+  if (!isBatchedRenderer(obj->render)) flushBatch();
+
+  if ((recordingList == NULL) || isDisplayListRenderer(obj->render)) {
+    obj->render(obj);
+    return;
+  }
+
+  // A renderer that draws through raylib directly cannot be recorded, so everything recorded so
+  // far is drawn first and the object goes straight to the target.
+  DisplayList *list = recordingList;
+  flushDisplayList(list);
+  recordingList = NULL;
+  obj->render(obj);
+  recordingList = list;
+}
+
+// -------------------------------------- Display List ---------------------------------------
+
+// Built-in renderers emit commands instead of calling raylib. While a list is being recorded
+// they are appended to it; otherwise they go through a scratch list and are drawn at once.
+// Sinks replay the same list, so a frame is evaluated and tessellated only once.
+
+DEFINE_VECTOR(DrawCommands, DrawCommand, commands, MEMORY_FRAMES)
+DEFINE_VECTOR(DrawVertices, Vector2, vertices, MEMORY_FRAMES)
+DEFINE_VECTOR(DrawColors, Color, colors, MEMORY_FRAMES)
+DEFINE_VECTOR(DrawChars, char, chars, MEMORY_FRAMES)
+
+static void drawTextRun(FontIndex fontIdx,
+                        const char *text,
+                        Vector2 position,
+                        float fontSize,
+                        float spacing,
+                        Color tint);
+
+void initDisplayList(DisplayList *list, int width, int height) {
+  initDrawCommands(&list->commands);
+  initDrawVertices(&list->vertices);
+  initDrawColors(&list->colors);
+  initDrawChars(&list->text);
+  list->background = BLANK;
+  list->width = width;
+  list->height = height;
+  list->replayed = 0;
+}
+
+static void clearDisplayList(DisplayList *list) {
+  clearDrawCommands(&list->commands);
+  clearDrawVertices(&list->vertices);
+  clearDrawColors(&list->colors);
+  clearDrawChars(&list->text);
+  list->replayed = 0;
+}
+
+void beginDisplayList(DisplayList *list, Color background) {
+  assert(recordingList == NULL);
+
+  clearDisplayList(list);
+  list->background = background;
+  recordingList = list;
+}
+
+void endDisplayList(void) {
+  flushBatch();
+  recordingList = NULL;
+}
+
+static void executeRaylibCommand(void *context, DisplayList *list, DrawCommand *command) {
+  (void)context;
+
+  switch (command->type) {
+    case DRAW_TRIANGLES:
+      drawTriangles(list->vertices.vertices + command->params.triangles.first,
+                    list->colors.colors + command->params.triangles.first,
+                    command->params.triangles.count);
+      break;
+    case DRAW_RING:
+    case DRAW_CIRCLE_SECTOR:
+      drawTriangles(list->vertices.vertices + command->params.ring.first,
+                    list->colors.colors + command->params.ring.first,
+                    command->params.ring.count);
+      break;
+    case DRAW_TEXT:
+      drawTextRun(command->params.text.fontIdx,
+                  getDrawCommandText(list, command),
+                  command->params.text.position,
+                  command->params.text.fontSize,
+                  command->params.text.spacing,
+                  command->color);
+      break;
+    case DRAW_TEXTURE: {
+      RATexture *texture = &textures[command->params.texture.textureIdx];
+      DrawTextureEx(texture->levels[command->params.texture.level],
+                    command->params.texture.position,
+                    0.0f,
+                    command->params.texture.scale,
+                    command->color);
+      break;
+    }
+    case DRAW_PUSH_TRANSFORM:
+      rlPushMatrix();
+      rlMultMatrixf(MatrixToFloat(command->params.transform));
+      break;
+    case DRAW_POP_TRANSFORM:
+      rlPopMatrix();
+      break;
+  }
+}
+
+// Draws the commands recorded since the last flush to the current raylib target.
+static void flushDisplayList(DisplayList *list) {
+  for (; list->replayed < list->commands.count; list->replayed++)
+    executeRaylibCommand(NULL, list, &list->commands.commands[list->replayed]);
+}
+
+static void pushDrawCommand(DrawCommand command) {
+  DisplayList *list = recordingList != NULL ? recordingList : &immediateList;
+  pushToDrawCommands(&list->commands, command);
+
+  if (recordingList == NULL) {
+    flushDisplayList(list);
+    clearDisplayList(list);
+  }
+}
+
+void emitTriangles(const Vector2 *vertices, const Color *colors, int vertexCount) {
+  DisplayList *list = recordingList != NULL ? recordingList : &immediateList;
+  int first = list->vertices.count;
+
+  reserveDrawVertices(&list->vertices, first + vertexCount);
+  reserveDrawColors(&list->colors, first + vertexCount);
+  memcpy(list->vertices.vertices + first, vertices, vertexCount * sizeof(Vector2));
+  memcpy(list->colors.colors + first, colors, vertexCount * sizeof(Color));
+  list->vertices.count += vertexCount;
+  list->colors.count += vertexCount;
+
+  DrawCommand command = {DRAW_TRIANGLES, BLANK, {.triangles = {first, vertexCount}}};
+  pushDrawCommand(command);
+}
+
+// Tessellates like DrawRing() and DrawCircleSector(), including their segment count for fewer
+// than four segments, so every sink replays the same triangles. A sector is a ring without a
+// hole.
+static void emitArc(DrawCommandType type,
+                    Vector2 center,
+                    float innerRadius,
+                    float outerRadius,
+                    float startAngle,
+                    float endAngle,
+                    int segments,
+                    Color color) {
+  if (startAngle > endAngle) {
+    float angle = startAngle;
+    startAngle = endAngle;
+    endAngle = angle;
+  }
+  if (outerRadius < innerRadius) {
+    float radius = innerRadius;
+    innerRadius = outerRadius;
+    outerRadius = radius;
+  }
+  if (startAngle == endAngle) return;
+  if (outerRadius <= 0.0f) outerRadius = 0.1f;
+  if (innerRadius <= 0.0f) type = DRAW_CIRCLE_SECTOR;
+
+  int minSegments = (int)ceilf((endAngle - startAngle) / 90.0f);
+  if (segments < minSegments) {
+    // raylib keeps the chord within half a pixel of the arc.
+    int smooth = 0;
+    if (outerRadius > 0.5f) {
+      float th = acosf(2 * powf(1 - 0.5f / outerRadius, 2) - 1);
+      smooth = (int)((endAngle - startAngle) * ceilf(2 * PI / th) / 360);
+    }
+    segments = smooth > 0 ? smooth : minSegments;
+  }
+  segments = getProxySegments(segments);
+
+  DisplayList *list = recordingList != NULL ? recordingList : &immediateList;
+  bool hollow = type == DRAW_RING;
+  int first = list->vertices.count;
+  int count = hollow ? segments * 6 : segments * 3;
+  reserveDrawVertices(&list->vertices, first + count);
+  reserveDrawColors(&list->colors, first + count);
+
+  Vector2 *vertices = list->vertices.vertices + first;
+  float step = (endAngle - startAngle) / segments;
+  Vector2 previous = {cosf(DEG2RAD * startAngle), sinf(DEG2RAD * startAngle)};
+
+  for (int i = 0; i < segments; i++) {
+    float angle = DEG2RAD * (startAngle + step * (i + 1));
+    Vector2 next = {cosf(angle), sinf(angle)};
+    Vector2 outerFrom = {center.x + previous.x * outerRadius, center.y + previous.y * outerRadius};
+    Vector2 outerTo = {center.x + next.x * outerRadius, center.y + next.y * outerRadius};
+
+    if (hollow) {
+      Vector2 innerFrom = {center.x + previous.x * innerRadius,
+                           center.y + previous.y * innerRadius};
+      Vector2 innerTo = {center.x + next.x * innerRadius, center.y + next.y * innerRadius};
+
+      vertices[0] = outerFrom;
+      vertices[1] = innerFrom;
+      vertices[2] = innerTo;
+      vertices[3] = outerTo;
+      vertices[4] = outerFrom;
+      vertices[5] = innerTo;
+      orientTriangle(vertices);
+      orientTriangle(vertices + 3);
+      vertices += 6;
+    } else {
+      vertices[0] = center;
+      vertices[1] = outerFrom;
+      vertices[2] = outerTo;
+      orientTriangle(vertices);
+      vertices += 3;
+    }
+    previous = next;
+  }
+
+  for (int i = first; i < first + count; i++) list->colors.colors[i] = color;
+  list->vertices.count += count;
+  list->colors.count += count;
+
+  DrawCommand command = {type, color, {.ring = {center,
+                                               innerRadius,
+                                               outerRadius,
+                                               startAngle,
+                                               endAngle,
+                                               segments,
+                                               first,
+                                               count}}};
+  pushDrawCommand(command);
+}
+
+void emitRing(Vector2 center,
+              float innerRadius,
+              float outerRadius,
+              float startAngle,
+              float endAngle,
+              int segments,
+              Color color) {
+  emitArc(DRAW_RING, center, innerRadius, outerRadius, startAngle, endAngle, segments, color);
+}
+
+void emitCircleSector(
+    Vector2 center, float radius, float startAngle, float endAngle, int segments, Color color) {
+  emitArc(DRAW_CIRCLE_SECTOR, center, 0.0f, radius, startAngle, endAngle, segments, color);
+}
+
+void emitText(FontIndex fontIdx,
+              const char *text,
+              Vector2 position,
+              float fontSize,
+              float spacing,
+              Color color) {
+  DisplayList *list = recordingList != NULL ? recordingList : &immediateList;
+  int offset = list->text.count;
+  int length = (int)strlen(text) + 1;
+
+  reserveDrawChars(&list->text, offset + length);
+  memcpy(list->text.chars + offset, text, length);
+  list->text.count += length;
+
+  DrawCommand command = {
+      DRAW_TEXT, color, {.text = {fontIdx, offset, position, fontSize, spacing}}};
+  pushDrawCommand(command);
+}
+
+void emitTexture(TextureIndex textureIdx, int level, Vector2 position, float scale, Color tint) {
+  DrawCommand command = {DRAW_TEXTURE, tint, {.texture = {textureIdx, level, position, scale}}};
+  pushDrawCommand(command);
+}
+
+void emitPushTransform(Matrix transform) {
+  DrawCommand command = {DRAW_PUSH_TRANSFORM, BLANK, {.transform = transform}};
+  pushDrawCommand(command);
+}
+
+void emitPopTransform(void) {
+  DrawCommand command = {DRAW_POP_TRANSFORM, BLANK, {.transform = MatrixIdentity()}};
+  pushDrawCommand(command);
+}
+
+bool isDisplayListRenderer(void (*render)(void *)) {
+  return isBatchedRenderer(render) || (render == renderDefaultCircle) ||
+         (render == renderFillInnerCircle) || (render == renderDefaultText) ||
+         (render == renderDefaultImage) || (render == renderDefaultGroup);
+}
+
+const char *getDrawCommandText(DisplayList *list, DrawCommand *command) {
+  return list->text.chars + command->params.text.offset;
+}
+
+void executeDisplayList(DisplayList *list,
+                        void (*execute)(void *, DisplayList *, DrawCommand *),
+                        void *context) {
+  for (int i = 0; i < list->commands.count; i++)
+    execute(context, list, &list->commands.commands[i]);
+}
+
+// Draws the whole list to the current raylib target, e.g. a second window or render texture.
+void replayDisplayList(DisplayList *list) {
+  ClearBackground(list->background);
+  BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+  executeDisplayList(list, executeRaylibCommand, NULL);
+  EndBlendMode();
+}
+
+static void hashDrawCommand(void *context, DisplayList *list, DrawCommand *command) {
+  RAHash *hash = (RAHash *)context;
+
+  *hash = hashBytes(*hash, &command->type, sizeof(command->type));
+  *hash = hashBytes(*hash, &command->color, sizeof(command->color));
+
+  switch (command->type) {
+    case DRAW_TRIANGLES: {
+      int first = command->params.triangles.first;
+      int count = command->params.triangles.count;
+      *hash = hashBytes(*hash, list->vertices.vertices + first, count * sizeof(Vector2));
+      *hash = hashBytes(*hash, list->colors.colors + first, count * sizeof(Color));
+      break;
+    }
+    case DRAW_RING:
+    case DRAW_CIRCLE_SECTOR:
+      *hash = hashBytes(*hash, &command->params.ring.center, sizeof(Vector2));
+      *hash = hashBytes(*hash, &command->params.ring.innerRadius, sizeof(float));
+      *hash = hashBytes(*hash, &command->params.ring.outerRadius, sizeof(float));
+      *hash = hashBytes(*hash, &command->params.ring.startAngle, sizeof(float));
+      *hash = hashBytes(*hash, &command->params.ring.endAngle, sizeof(float));
+      *hash = hashBytes(*hash, &command->params.ring.segments, sizeof(int));
+      break;
+    case DRAW_TEXT: {
+      const char *text = getDrawCommandText(list, command);
+      *hash = hashBytes(*hash, &command->params.text.fontIdx, sizeof(FontIndex));
+      *hash = hashBytes(*hash, text, strlen(text));
+      *hash = hashBytes(*hash, &command->params.text.position, sizeof(Vector2));
+      *hash = hashBytes(*hash, &command->params.text.fontSize, sizeof(float));
+      *hash = hashBytes(*hash, &command->params.text.spacing, sizeof(float));
+      break;
+    }
+    case DRAW_TEXTURE:
+      *hash = hashBytes(*hash, &command->params.texture.textureIdx, sizeof(TextureIndex));
+      *hash = hashBytes(*hash, &command->params.texture.level, sizeof(int));
+      *hash = hashBytes(*hash, &command->params.texture.position, sizeof(Vector2));
+      *hash = hashBytes(*hash, &command->params.texture.scale, sizeof(float));
+      break;
+    case DRAW_PUSH_TRANSFORM:
+      *hash = hashBytes(*hash, &command->params.transform, sizeof(Matrix));
+      break;
+    case DRAW_POP_TRANSFORM:
+      break;
+  }
+}
+
+RAHash hashDisplayList(DisplayList *list) {
+  RAHash hash = FNV_OFFSET_BASIS;
+
+  hash = hashBytes(hash, &list->width, sizeof(list->width));
+  hash = hashBytes(hash, &list->height, sizeof(list->height));
+  hash = hashBytes(hash, &list->background, sizeof(list->background));
+  executeDisplayList(list, hashDrawCommand, &hash);
+
+  return hash;
+}
+
+// SVG wants straight alpha, while recorded colors are premultiplied.
+static void writeSvgFill(FILE *file, Color color) {
+  float alpha = color.a / 255.0f;
+  float scale = color.a > 0 ? 255.0f / color.a : 0.0f;
+
+  fprintf(file,
+          "fill=\"rgb(%d,%d,%d)\" fill-opacity=\"%.3f\"",
+          (int)fminf(color.r * scale, 255.0f),
+          (int)fminf(color.g * scale, 255.0f),
+          (int)fminf(color.b * scale, 255.0f),
+          alpha);
+}
+
+static void writeSvgArc(FILE *file, DrawCommand *command, float radius, bool reverse) {
+  float start = command->params.ring.startAngle;
+  float end = command->params.ring.endAngle;
+  int segments = command->params.ring.segments > 0 ? command->params.ring.segments : 1;
+  Vector2 center = command->params.ring.center;
+
+  for (int i = 0; i <= segments; i++) {
+    float t = (float)(reverse ? segments - i : i) / segments;
+    float angle = DEG2RAD * (start + (end - start) * t);
+    fprintf(file, "%.2f,%.2f ", center.x + cosf(angle) * radius, center.y + sinf(angle) * radius);
+  }
+}
+
+static void writeSvgCommand(void *context, DisplayList *list, DrawCommand *command) {
+  FILE *file = (FILE *)context;
+
+  switch (command->type) {
+    case DRAW_TRIANGLES: {
+      int first = command->params.triangles.first;
+
+      for (int i = first; i < first + command->params.triangles.count; i += 3) {
+        Vector2 *v = list->vertices.vertices + i;
+        fprintf(file,
+                "<polygon points=\"%.2f,%.2f %.2f,%.2f %.2f,%.2f\" ",
+                v[0].x,
+                v[0].y,
+                v[1].x,
+                v[1].y,
+                v[2].x,
+                v[2].y);
+        writeSvgFill(file, list->colors.colors[i]);
+        fprintf(file, "/>\n");
+      }
+      break;
+    }
+    case DRAW_RING:
+    case DRAW_CIRCLE_SECTOR:
+      fprintf(file, "<polygon points=\"");
+      writeSvgArc(file, command, command->params.ring.outerRadius, false);
+      writeSvgArc(file, command, command->params.ring.innerRadius, true);
+      fprintf(file, "\" ");
+      writeSvgFill(file, command->color);
+      fprintf(file, "/>\n");
+      break;
+    case DRAW_TEXT: {
+      fprintf(file,
+              "<text x=\"%.2f\" y=\"%.2f\" font-size=\"%.2f\" letter-spacing=\"%.2f\" "
+              "dominant-baseline=\"hanging\" ",
+              command->params.text.position.x,
+              command->params.text.position.y,
+              command->params.text.fontSize,
+              command->params.text.spacing);
+      writeSvgFill(file, command->color);
+      fprintf(file, ">");
+
+      for (const char *c = getDrawCommandText(list, command); *c != '\0'; c++) {
+        if (*c == '<') {
+          fprintf(file, "&lt;");
+        } else if (*c == '>') {
+          fprintf(file, "&gt;");
+        } else if (*c == '&') {
+          fprintf(file, "&amp;");
+        } else {
+          fputc(*c, file);
+        }
+      }
+
+      fprintf(file, "</text>\n");
+      break;
+    }
+    case DRAW_TEXTURE: {
+      // Texture pixels are not part of the list, so images are exported as their footprint.
+      Texture level =
+          textures[command->params.texture.textureIdx].levels[command->params.texture.level];
+      fprintf(file,
+              "<rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" "
+              "data-texture=\"%d\" ",
+              command->params.texture.position.x,
+              command->params.texture.position.y,
+              level.width * command->params.texture.scale,
+              level.height * command->params.texture.scale,
+              command->params.texture.textureIdx);
+      writeSvgFill(file, command->color);
+      fprintf(file, "/>\n");
+      break;
+    }
+    case DRAW_PUSH_TRANSFORM: {
+      Matrix m = command->params.transform;
+      fprintf(file,
+              "<g transform=\"matrix(%f %f %f %f %f %f)\">\n",
+              m.m0,
+              m.m1,
+              m.m4,
+              m.m5,
+              m.m12,
+              m.m13);
+      break;
+    }
+    case DRAW_POP_TRANSFORM:
+      fprintf(file, "</g>\n");
+      break;
+  }
+}
+
+bool exportDisplayListSvg(DisplayList *list, const char *filename) {
+  FILE *file = fopen(filename, "w");
+  if (file == NULL) {
+    TraceLog(LOG_WARNING, "RayAnim: Failed to write %s", filename);
+    return false;
+  }
+
+  fprintf(file,
+          "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" "
+          "viewBox=\"0 0 %d %d\">\n",
+          list->width,
+          list->height,
+          list->width,
+          list->height);
+  fprintf(file, "<rect width=\"100%%\" height=\"100%%\" ");
+  writeSvgFill(file, list->background);
+  fprintf(file, "/>\n");
+
+  executeDisplayList(list, writeSvgCommand, file);
+
+  fprintf(file, "</svg>\n");
+  fclose(file);
+  return true;
+}
+
+void destroyDisplayList(DisplayList *list) {
+  destroyDrawCommands(&list->commands);
+  destroyDrawVertices(&list->vertices);
+  destroyDrawColors(&list->colors);
+  destroyDrawChars(&list->text);
+}
+
+// ------------------------------ Built-In RAObjects & Animations ------------------------------
+
+// --------------- RACircle ---------------
+
+void initCircle(RACircle *RACircle,
+                Vector2 center,
+                float radius,
+                float outlineThickness,
+                int segments,
+                Color innerColor,
+                Color outlineColor,
+                void (*render)(void *)) {
+  initRAObject(&RACircle->base, center, innerColor, render);
+  RACircle->base.hash = hashDefaultCircle;
+  RACircle->base.bounds = boundsDefaultCircle;
+  RACircle->radius = radius;
+  RACircle->angle = 0.0f;
+  RACircle->outlineThickness = outlineThickness;
+  RACircle->segments = segments;
+  RACircle->outlineColor = outlineColor;
+}
+
+void initDefaultCircle(RACircle *RACircle, Vector2 center, float radius) {
+  initCircle(RACircle, center, radius, 25.0f, 100, BLUE, DARKBLUE, renderDefaultCircle);
+}
+
+RACircle createCircle(Vector2 center, float radius) {
+  RACircle RACircle;
+  initDefaultCircle(&RACircle, center, radius);
+  return RACircle;
+}
+
+void renderDefaultCircle(void *self) {
+  RACircle *circle = (RACircle *)self;
+  Color outlineColor = resolveRAObjectColor(&circle->base, circle->outlineColor);
+
+  float innerRadius = circle->radius - circle->outlineThickness / 2;
+  float outerRadius = circle->radius + circle->outlineThickness / 2;
+  emitRing(circle->base.position,
+           innerRadius,
+           outerRadius,
+           0.0f,
+           circle->angle,
+           circle->segments,
+           outlineColor);
+}
+
+void renderFillInnerCircle(void *self) {
+  RACircle *circle = (RACircle *)self;
+  Color innerColor = resolveRAObjectColor(&circle->base, circle->base.color);
+  Color outlineColor = resolveRAObjectColor(&circle->base, circle->outlineColor);
+
+  float halfThickness = circle->outlineThickness / 2;
+
+  emitCircleSector(circle->base.position,
+                   circle->radius + halfThickness,
+                   0.0f,
+                   circle->angle,
+                   circle->segments,
+                   outlineColor);
+
+  emitCircleSector(circle->base.position,
+                   circle->radius - halfThickness,
+                   0.0f,
+                   circle->angle,
+                   circle->segments,
+                   innerColor);
+}
+
+RAHash hashDefaultCircle(void *self, RAHash hash) {
+  RACircle *circle = (RACircle *)self;
+
+  hash = hashRAObjectBase(&circle->base, hash);
+  hash = hashBytes(hash, &circle->radius, sizeof(circle->radius));
+  hash = hashBytes(hash, &circle->outlineThickness, sizeof(circle->outlineThickness));
+  hash = hashBytes(hash, &circle->segments, sizeof(circle->segments));
+  hash = hashBytes(hash, &circle->outlineColor, sizeof(circle->outlineColor));
+  hash = hashBytes(hash, &circle->angle, sizeof(circle->angle));
+
+  return hash;
+}
+
+Rectangle boundsDefaultCircle(void *self) {
+  RACircle *circle = (RACircle *)self;
+  float outerRadius = circle->radius + circle->outlineThickness / 2;
+
+  return (Rectangle){circle->base.position.x - outerRadius,
+                     circle->base.position.y - outerRadius,
+                     outerRadius * 2,
+                     outerRadius * 2};
+}
+
+void initCircleAnimation(Animation *anim,
+                         RACircle *RACircle,
+                         float duration,
+                         bool (*update)(void *, double),
+                         void (*interpolate)(void *, float)) {
+  initAnimation(
+      anim, (RAObject *)RACircle, duration, update, interpolate, pushToObjectsDefaultAnimation);
+}
+
+void initDefaultCircleAnimation(Animation *anim, RACircle *RACircle) {
+  initCircleAnimation(
+      anim, RACircle, 0.8f, updateDefaultAnimation, interpolateDefaultCircleAnimation);
+}
+
+Animation createCircleAnimation(RACircle *RACircle) {
+  Animation anim;
+  initDefaultCircleAnimation(&anim, RACircle);
+  return anim;
+}
+void interpolateDefaultCircleAnimation(void *self, float time) {
+  Animation *anim = (Animation *)self;
+  RACircle *circle = (RACircle *)anim->object;
+  circle->angle = time * 360.0f;
+}
+
+// --------------- RACircle ---------------
+
+// ------------- RARectangle --------------
+
+void initRectangle(RARectangle *rect,
+                   Vector2 position,
+                   float width,
+                   float height,
+                   float outlineThickness,
+                   Color innerColor,
+                   Color outlineColor,
+                   void (*render)(void *)) {
+  initRAObject(&rect->base, position, innerColor, render);
+  rect->base.hash = hashDefaultRectangle;
+  rect->base.bounds = boundsDefaultRectangle;
+  rect->width = width;
+  rect->height = height;
+  rect->outlineThickness = outlineThickness;
+  rect->outlineColor = outlineColor;
+
+  rect->firstQuarter = 0.0f;
+  rect->secondQuarter = 0.0f;
+  rect->thirdQuarter = 0.0f;
+  rect->lastQuarter = 0.0f;
+}
+
+void initDefaultRectangle(RARectangle *rect, Vector2 position, float width, float height) {
+  initRectangle(rect, position, width, height, 25.0f, GREEN, DARKGREEN, renderDefaultRectangle);
+}
+
+RARectangle createRectangle(Vector2 position, float width, float height) {
+  RARectangle rect;
+  initDefaultRectangle(&rect, position, width, height);
+  return rect;
+}
+
+// The outline is drawn clockwise from the top-left corner, one side per quarter of the animation.
+static void getRectangleSides(RARectangle *rect, Rectangle sides[4]) {
+  float x = rect->base.position.x;
+  float y = rect->base.position.y;
+  float width = rect->width;
+  float height = rect->height;
+  float thickness = rect->outlineThickness;
+  float top = (width - thickness) * rect->firstQuarter;
+  float right = (height - thickness) * rect->secondQuarter;
+  float bottom = (width - thickness) * rect->thirdQuarter;
+  float left = (height - thickness) * rect->lastQuarter;
+
+  sides[0] = (Rectangle){x, y, top, thickness};
+  sides[1] = (Rectangle){x + width - thickness, y, thickness, right};
+  sides[2] = (Rectangle){x + width - bottom, y + height - thickness, bottom, thickness};
+  sides[3] = (Rectangle){x, y + height - left, thickness, left};
+}
+
+void renderDefaultRectangle(void *self) {
+  RARectangle *rect = (RARectangle *)self;
+  Color outlineColor = resolveRAObjectColor(&rect->base, rect->outlineColor);
+
+  Rectangle sides[4];
+  getRectangleSides(rect, sides);
+
+  for (int i = 0; i < 4; i++) batchRectangle(sides[i], outlineColor);
 }
 
 void renderFillInnerRectangle(void *self) {
   RARectangle *rect = (RARectangle *)self;
-  rect->outlineColor.a = rect->base.color.a;
+  Color innerColor = resolveRAObjectColor(&rect->base, rect->base.color);
+  Color outlineColor = resolveRAObjectColor(&rect->base, rect->outlineColor);
+
+  float x = rect->base.position.x;
+  float y = rect->base.position.y;
+  float width = rect->width;
+  float height = rect->height;
+  float thickness = rect->outlineThickness;
+  float secondQuarter = rect->secondQuarter;
+  float thirdQuarter = rect->thirdQuarter;
+
+  Rectangle sides[4];
+  getRectangleSides(rect, sides);
+
+  batchRectangle(sides[0], outlineColor);
+  batchRectangle(sides[1], outlineColor);
+
+  batchTriangle((Vector2){x + thickness, y + thickness},
+                (Vector2){x + width - thickness, y + (height - thickness) * secondQuarter},
+                (Vector2){x + width - thickness, y + thickness},
+                innerColor);
+
+  batchRectangle(sides[2], outlineColor);
+
+  batchTriangle((Vector2){x + thickness, y + thickness},
+                (Vector2){(x + width) - (width - thickness) * thirdQuarter, y + height - thickness},
+                (Vector2){x + width - thickness, y + height - thickness},
+                innerColor);
+
+  batchRectangle(sides[3], outlineColor);
+}
+
+RAHash hashDefaultRectangle(void *self, RAHash hash) {
+  RARectangle *rect = (RARectangle *)self;
+
+  hash = hashRAObjectBase(&rect->base, hash);
+  hash = hashBytes(hash, &rect->width, sizeof(rect->width));
+  hash = hashBytes(hash, &rect->height, sizeof(rect->height));
+  hash = hashBytes(hash, &rect->outlineThickness, sizeof(rect->outlineThickness));
+  hash = hashBytes(hash, &rect->outlineColor, sizeof(rect->outlineColor));
+  hash = hashBytes(hash, &rect->firstQuarter, sizeof(rect->firstQuarter));
+  hash = hashBytes(hash, &rect->secondQuarter, sizeof(rect->secondQuarter));
+  hash = hashBytes(hash, &rect->thirdQuarter, sizeof(rect->thirdQuarter));
+  hash = hashBytes(hash, &rect->lastQuarter, sizeof(rect->lastQuarter));
+
+  return hash;
+}
+
+Rectangle boundsDefaultRectangle(void *self) {
+  RARectangle *rect = (RARectangle *)self;
+  return (Rectangle){rect->base.position.x, rect->base.position.y, rect->width, rect->height};
+}
+
+void initRectangleAnimation(Animation *anim,
+                            RARectangle *rect,
+                            float duration,
+                            bool (*update)(void *, double),
+                            void (*interpolate)(void *, float)) {
+  initAnimation(
+      anim, (RAObject *)rect, duration, update, interpolate, pushToObjectsDefaultAnimation);
+}
+
+void initDefaultRectangleAnimation(Animation *anim, RARectangle *rect) {
+  initRectangleAnimation(
+      anim, rect, 0.7, updateDefaultAnimation, interpolateDefaultRectangleAnimation);
+}
+
+Animation createRectangleAnimation(RARectangle *rect) {
+  Animation anim;
+  initDefaultRectangleAnimation(&anim, rect);
+  return anim;
+}
+
+void interpolateDefaultRectangleAnimation(void *self, float time) {
+  (void)time;
+
+  Animation *anim = (Animation *)self;
+  RARectangle *rect = (RARectangle *)anim->object;
+
+  float elapsedTime = (float)anim->elapsedTime;
+  float quarterDuration = anim->duration / 4.0f;
+
+  rect->firstQuarter = fminf(elapsedTime / quarterDuration, 1.0f);
+
+  if ((elapsedTime - quarterDuration) > 0)
+    rect->secondQuarter = fminf((elapsedTime - quarterDuration) / quarterDuration, 1.0f);
+
+  if ((elapsedTime - quarterDuration * 2) > 0)
+    rect->thirdQuarter = fminf((elapsedTime - quarterDuration * 2) / quarterDuration, 1.0f);
+
+  if ((elapsedTime - quarterDuration * 3) > 0)
+    rect->lastQuarter = fminf((elapsedTime - quarterDuration * 3) / quarterDuration, 1.0f);
+}
+
+// ------------- RARectangle --------------
+
+// -------------- RASquare ----------------
+
+void initSquare(RARectangle *square,
+                Vector2 position,
+                float length,
+                float outlineThickness,
+                Color innerColor,
+                Color outlineColor,
+                void (*render)(void *)) {
+  initRectangle(
+      square, position, length, length, outlineThickness, innerColor, outlineColor, render);
+}
+
+void initDefaultSquare(RARectangle *square, Vector2 position, float length) {
+  initDefaultRectangle(square, position, length, length);
+}
+
+RARectangle createSquare(Vector2 position, float length) {
+  RARectangle square;
+  initDefaultSquare(&square, position, length);
+  return square;
+}
+
+// -------------- RASquare ----------------
+
+// ---------------- RADelay ----------------
+
+static RAObject wait_object;
+
+void initDelayAnimation(Animation *anim, float duration) {
+  initEmptyRAObject(&wait_object);
+  initAnimation(anim,
+                &wait_object,
+                duration,
+                updateDefaultAnimation,
+                interpolateDelayAnimation,
+                pushToObjectsDefaultAnimation);
+}
+
+Animation createDelayAnimation(float duration) {
+  Animation anim;
+  initDelayAnimation(&anim, duration);
+  return anim;
+}
+
+void interpolateDelayAnimation(void *self, float time) {
+  (void)time;
+  (void)self;
+}
+
+// ---------------- RADelay ----------------
+
+// ---------------- FadeOut ----------------
+
+void initFadeOutAnimation(Animation *anim,
+                          RAObject *obj,
+                          float duration,
+                          bool (*update)(void *, double),
+                          void (*interpolate)(void *, float)) {
+  initAnimation(anim, obj, duration, update, interpolate, pushToObjectsDefaultAnimation);
+}
+
+void initDefaultFadeOutAnimation(Animation *anim, RAObject *obj) {
+  initFadeOutAnimation(anim, obj, 1.0f, updateDefaultAnimation, interpolateDefaultFadeOutAnimation);
+}
+
+Animation createFadeOutAnimation(RAObject *obj) {
+  Animation anim;
+  initDefaultFadeOutAnimation(&anim, obj);
+  return anim;
+}
+
+void interpolateDefaultFadeOutAnimation(void *self, float time) {
+  Animation *anim = (Animation *)self;
+  anim->object->opacity = 1.0f - time;
+}
+
+// ---------------- FadeOut ----------------
+
+// ----------------- Sync ------------------
+
+void initSyncAnimation(SyncAnimation *anim,
+                       Animation **anims,
+                       int animCount,
+                       void (*pushToObjects)(Scene *)) {
+  initAnimation((Animation *)anim,
+                NULL,
+                0,
+                updateDefaultSyncAnimation,
+                interpolateDefaultSyncAnimation,
+                pushToObjects);
+  anim->base.reset = resetDefaultSyncAnimation;
+  anim->animations = anims;
+  anim->animCount = animCount;
+  anim->independent = -1;
+}
+
+void initDefaultSyncAnimation(SyncAnimation *anim, Animation **anims, int animCount) {
+  initSyncAnimation(anim, anims, animCount, pushToObjectsDefaultSyncAnimation);
+}
+
+SyncAnimation createSyncAnimation(Animation **anims, int animCount) {
+  SyncAnimation anim;
+  initDefaultSyncAnimation(&anim, anims, animCount);
+  return anim;
+}
+
+// Counts the objects an animation writes to. Syncs and moves write through their children and
+// delays write nothing; any other animation without an object may write anywhere and makes the
+// count -1.
+static int countAnimationObjects(Animation *anim) {
+  if (anim->update == updateDefaultSyncAnimation) {
+    SyncAnimation *sync = (SyncAnimation *)anim;
+    int count = 0;
+
+    for (int i = 0; i < sync->animCount; i++) {
+      int childCount = countAnimationObjects(sync->animations[i]);
+      if (childCount < 0) return -1;
+      count += childCount;
+    }
+
+    return count;
+  }
+
+  if (anim->update == updateDefaultMoveAnimation)
+    return countAnimationObjects(((MoveAnimation *)anim)->targetAnim);
+  if (anim->interpolate == interpolateDelayAnimation) return 0;
+
+  return anim->object != NULL ? 1 : -1;
+}
+
+static void collectAnimationRoots(Animation *anim, RAObject **roots, int *count) {
+  if (anim->update == updateDefaultSyncAnimation) {
+    SyncAnimation *sync = (SyncAnimation *)anim;
+    for (int i = 0; i < sync->animCount; i++)
+      collectAnimationRoots(sync->animations[i], roots, count);
+  } else if (anim->update == updateDefaultMoveAnimation) {
+    collectAnimationRoots(((MoveAnimation *)anim)->targetAnim, roots, count);
+  } else if (anim->interpolate != interpolateDelayAnimation) {
+    roots[(*count)++] = getRootRAObject(anim->object);
+  }
+}
+
+static int compareObjectAddresses(const void *a, const void *b) {
+  uintptr_t addressA = (uintptr_t)*(RAObject *const *)a;
+  uintptr_t addressB = (uintptr_t)*(RAObject *const *)b;
+  return (addressA > addressB) - (addressA < addressB);
+}
+
+// Animations can run on different threads only if no two of them write into the same tree of
+// objects, since marking an object dirty also bumps the revision of every group above it.
+static bool areAnimationsIndependent(Animation **anims, int animCount) {
+  int count = 0;
+  for (int i = 0; i < animCount; i++) {
+    int objectCount = countAnimationObjects(anims[i]);
+    if (objectCount < 0) return false;
+    count += objectCount;
+  }
+
+  RAObject **roots = allocateMemory(MEMORY_SCENE, (count > 0 ? count : 1) * sizeof(RAObject *));
+  assert(roots != NULL);
+
+  count = 0;
+  for (int i = 0; i < animCount; i++) collectAnimationRoots(anims[i], roots, &count);
+  qsort(roots, count, sizeof(RAObject *), compareObjectAddresses);
+
+  bool independent = true;
+  for (int i = 1; (i < count) && independent; i++) independent = roots[i] != roots[i - 1];
+
+  releaseMemory(roots);
+  return independent;
+}
+
+// Children of a large sync group are updated in chunks on the shared pool when none of them
+// share a tree of objects; otherwise they run in order on the calling thread.
+typedef struct SyncChunkContext {
+  SyncAnimation *anim;
+  double time;
+  int *chunkCompleted;
+} SyncChunkContext;
+
+static void updateSyncChunk(void *context, int start, int end) {
+  SyncChunkContext *chunk = (SyncChunkContext *)context;
+  int completedNum = 0;
+
+  for (int i = start; i < end; i++) {
+    Animation *each = chunk->anim->animations[i];
+    if (each->update(each, chunk->time)) completedNum++;
+  }
+
+  chunk->chunkCompleted[start / SYNC_PARALLEL_CHUNK] = completedNum;
+}
+
+bool updateDefaultSyncAnimation(void *self, double time) {
+  SyncAnimation *anim = (SyncAnimation *)self;
+
+  if (anim->base.done) return true;
+
+  anim->base.elapsedTime = time;
+  int completedNum = 0;
+
+  RAThreadPool *pool = getSharedThreadPool();
+  bool parallel = (anim->animCount >= SYNC_PARALLEL_THRESHOLD) && (pool->workerCount > 0);
+
+  if (parallel && (anim->independent < 0))
+    anim->independent = areAnimationsIndependent(anim->animations, anim->animCount);
+
+  if (parallel && anim->independent) {
+    int chunkCount = (anim->animCount + SYNC_PARALLEL_CHUNK - 1) / SYNC_PARALLEL_CHUNK;
+    int chunkCompleted[chunkCount];
+    SyncChunkContext context = {anim, time, chunkCompleted};
+
+    parallelFor(pool, anim->animCount, SYNC_PARALLEL_CHUNK, updateSyncChunk, &context);
+
+    for (int i = 0; i < chunkCount; i++) completedNum += chunkCompleted[i];
+  } else {
+    for (int i = 0; i < anim->animCount; i++) {
+      Animation *each = anim->animations[i];
+      if (each->update(each, time)) completedNum++;
+    }
+  }
+
+  bool completed = completedNum == anim->animCount;
+  if (completed) anim->base.done = true;
+
+  return completed;
+}
+
+void interpolateDefaultSyncAnimation(void *self, float time) {
+  (void)self;
+  (void)time;
+}
+
+// Objects may have been regrouped since the last run, so independence is checked again.
+void resetDefaultSyncAnimation(void *self) {
+  ((SyncAnimation *)self)->independent = -1;
+}
+
+void pushToObjectsDefaultSyncAnimation(Scene *scene) {
+  SyncAnimation *anim = (SyncAnimation *)scene->currentAnimation;
+
+  for (int i = 0; i < anim->animCount; i++) {
+    Animation *eachAnim = anim->animations[i];
+    startAnimation(eachAnim);
+    showRAObjectInScene(scene, eachAnim->object);
+
+    TraceLog(LOG_INFO, "RayAnim: Started Animation #%i", eachAnim->_id);
+  }
+}
+
+// ----------------- Sync ------------------
+
+// ----------------- Move ------------------
+
+void initMoveAnimation(MoveAnimation *anim,
+                       Animation *targetAnim,
+                       float duration,
+                       Vector2 targetPos,
+                       bool (*update)(void *, double),
+                       void (*interpolate)(void *, float),
+                       void (*pushToObjects)(Scene *)) {
+  assert((targetAnim != NULL) && (targetAnim->object != NULL));
+  initAnimation((Animation *)anim, NULL, duration, update, interpolate, pushToObjects);
+  anim->targetAnim = targetAnim;
+  anim->initialPosition = targetAnim->object->position;
+  anim->targetPosition = targetPos;
+}
+
+void initDefaultMoveAnimation(MoveAnimation *anim, Animation *targetAnim, Vector2 targetPos) {
+  initMoveAnimation(anim,
+                    targetAnim,
+                    0.8f,
+                    targetPos,
+                    updateDefaultMoveAnimation,
+                    NULL,
+                    pushToObjectsDefaultMoveAnimation);
+}
+
+MoveAnimation createMoveAnimation(Animation *targetAnim, Vector2 targetPos) {
+  MoveAnimation anim;
+  initDefaultMoveAnimation(&anim, targetAnim, targetPos);
+  return anim;
+}
+
+bool updateDefaultMoveAnimation(void *self, double time) {
+  MoveAnimation *anim = (MoveAnimation *)self;
+  Animation *targetAnim = anim->targetAnim;
+
+  if (anim->base.done && targetAnim->done) return true;
+
+  anim->base.elapsedTime = time;
+
+  float t = fminf((float)(time / anim->base.duration), 1.0f);
+  float dx = (anim->targetPosition.x - anim->initialPosition.x) * t;
+  float dy = (anim->targetPosition.y - anim->initialPosition.y) * t;
+
+  anim->targetAnim->object->position.x = anim->initialPosition.x + dx;
+  anim->targetAnim->object->position.y = anim->initialPosition.y + dy;
+  markRAObjectDirty(anim->targetAnim->object);
+
+  bool innerAnimCompleted = targetAnim->update(targetAnim, time);
+
+  bool selfCompleted = anim->base.elapsedTime >= anim->base.duration;
+  if (selfCompleted) anim->base.done = true;
+
+  return innerAnimCompleted && selfCompleted;
+}
+
+void pushToObjectsDefaultMoveAnimation(Scene *scene) {
+  MoveAnimation *anim = (MoveAnimation *)scene->currentAnimation;
+  TraceLog(LOG_INFO, "RayAnim: Started Animation #%i", anim->base._id);
+  showRAObjectInScene(scene, anim->targetAnim->object);
+}
+
+// ----------------- Move ------------------
+
+// ---------------- RAText ----------------
+
+void initText(RAText *text,
+              char *fullText,
+              FontIndex fontIdx,
+              Color tint,
+              float charRevealTime,
+              float fontSize,
+              float spacing,
+              Vector2 pos,
+              void (*render)(void *)) {
+  initRAObject(&text->base, pos, tint, render);
+  text->base.hash = hashDefaultText;
+  text->base.bounds = boundsDefaultText;
+  text->spacing = spacing;
+  text->fontSize = fontSize;
+  text->fullText = fullText;
+  text->displayCharCount = 0;
+  text->charRevealTime = charRevealTime;
+  text->fontIdx = fontIdx;
+}
+
+void initDefaultText(RAText *text, char *fullText, Vector2 pos) {
+  initText(text, fullText, 0, BLACK, 0.03f, 100, 12.5f, pos, renderDefaultText);
+}
+
+RAText createText(char *fullText, Vector2 pos) {
+  RAText text;
+  initDefaultText(&text, fullText, pos);
+  return text;
+}
+
+// Distance fields are stored in the atlas alpha with the glyph edge at 0.5. The smoothing width
+// follows the screen-space derivative, so edges stay one pixel wide at any size or scale.
+static const char *sdfFragmentShader =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform vec4 colDiffuse;\n"
+    "out vec4 finalColor;\n"
+    "void main() {\n"
+    "  float distance = texture(texture0, fragTexCoord).a;\n"
+    "  float smoothing = max(fwidth(distance) * 0.7, 0.001);\n"
+    "  float alpha = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);\n"
+    "  finalColor = fragColor * colDiffuse * alpha;\n"
+    "}\n";
+
+static Shader sdfShader = {0};
+
+static void unloadSdfShader(void) {
+  if (sdfShader.id != 0) UnloadShader(sdfShader);
+  sdfShader = (Shader){0};
+}
+
+void renderDefaultText(void *self) {
+  RAText *text = (RAText *)self;
+
+  Color tint = resolveRAObjectColor(&text->base, text->base.color);
+  char displayText[text->displayCharCount];
+
+  strncpy(displayText, text->fullText, text->displayCharCount - 1);
+  displayText[text->displayCharCount - 1] = '\0';
+
+  emitText(text->fontIdx, displayText, text->base.position, text->fontSize, text->spacing, tint);
+}
+
+static void drawTextRun(FontIndex fontIdx,
+                        const char *text,
+                        Vector2 position,
+                        float fontSize,
+                        float spacing,
+                        Color tint) {
+  Font font = fonts[fontIdx];
+
+  if (!sdfFonts[fontIdx]) {
+    DrawTextEx(font, text, position, fontSize, spacing, tint);
+    return;
+  }
+
+  if (sdfShader.id == 0) sdfShader = LoadShaderFromMemory(NULL, sdfFragmentShader);
+
+  BeginShaderMode(sdfShader);
+  DrawTextEx(font, text, position, fontSize, spacing, tint);
+  EndShaderMode();
+}
+
+RAHash hashDefaultText(void *self, RAHash hash) {
+  RAText *text = (RAText *)self;
+  size_t visibleCount = text->displayCharCount > 0 ? text->displayCharCount - 1 : 0;
+
+  if (fontIdentities[text->fontIdx] == 0) markFrameUncacheable();
+
+  hash = hashRAObjectBase(&text->base, hash);
+  hash = hashBytes(hash, &fontIdentities[text->fontIdx], sizeof(RAHash));
+  hash = hashBytes(hash, &text->spacing, sizeof(text->spacing));
+  hash = hashBytes(hash, &text->fontSize, sizeof(text->fontSize));
+  hash = hashBytes(hash, text->fullText, visibleCount);
+
+  return hash;
+}
+
+Rectangle boundsDefaultText(void *self) {
+  RAText *text = (RAText *)self;
+  Vector2 size = MeasureTextEx(fonts[text->fontIdx], text->fullText, text->fontSize, text->spacing);
+
+  return (Rectangle){text->base.position.x, text->base.position.y, size.x, size.y};
+}
+
+static RAHash getFontIdentity(
+    const char *filename, int fontSize, bool sdf, const int *codepoints, int codepointCount) {
+  int key[2] = {fontSize, sdf};
+  RAHash hash = getAssetIdentity(filename, key, sizeof(key));
+
+  if (codepoints != NULL) hash = hashBytes(hash, codepoints, codepointCount * sizeof(int));
+  return hash;
+}
+
+void setFontForText(RAText *text, char *filename) {
+  RAHash identity = getFontIdentity(filename, 0, false, NULL, 0);
+  text->fontIdx = findLoadedFont(filename, identity);
+  if (text->fontIdx >= 0) return;
+
+  text->fontIdx = 0;
+  if (!hasFreeFontSlot(filename)) return;
+
+  fonts[fontCount] = LoadFont(filename);
+  premultiplyTexture(fonts[fontCount].texture);
+  trackFont(fonts[fontCount]);
+  sdfFonts[fontCount] = false;
+  setAssetFilename(fontFilenames[fontCount], filename);
+  fontIdentities[fontCount] = identity;
+  text->fontIdx = fontCount++;
+}
+
+// Fonts with a custom codepoint list are not shared, as the list is not part of the key.
+void setFontForTextEx(
+    RAText *text, char *filename, int fontSize, int *codepoints, int codepointCount) {
+  RAHash identity = getFontIdentity(filename, fontSize, false, codepoints, codepointCount);
+  text->fontIdx = codepoints == NULL ? findLoadedFont(filename, identity) : -1;
+  if (text->fontIdx >= 0) return;
+
+  text->fontIdx = 0;
+  if (!hasFreeFontSlot(filename)) return;
+
+  fonts[fontCount] = LoadFontEx(filename, fontSize, codepoints, codepointCount);
+  premultiplyTexture(fonts[fontCount].texture);
+  trackFont(fonts[fontCount]);
+  sdfFonts[fontCount] = false;
+  setAssetFilename(fontFilenames[fontCount], codepoints == NULL ? filename : NULL);
+  fontIdentities[fontCount] = identity;
+  text->fontIdx = fontCount++;
+}
+
+// Builds a small distance field atlas at SDF_FONT_SIZE that stays sharp at any fontSize. Each
+// file is loaded once and shared by every text that uses it. A NULL codepoint list loads ASCII.
+FontIndex loadSdfFont(const char *filename, int *codepoints, int codepointCount) {
+  RAHash identity = getFontIdentity(filename, SDF_FONT_SIZE, true, codepoints, codepointCount);
+  int loaded = findLoadedFont(filename, identity);
+  if (loaded >= 0) return loaded;
+  if (!hasFreeFontSlot(filename)) return 0;
+
+  int fileSize = 0;
+  unsigned char *fileData = LoadFileData(filename, &fileSize);
+  if (fileData == NULL) {
+    TraceLog(LOG_WARNING, "RayAnim: Failed to load SDF font %s", filename);
+    return 0;
+  }
+
+  Font font = {0};
+  font.baseSize = SDF_FONT_SIZE;
+  font.glyphCount = codepointCount > 0 ? codepointCount : 95;
+  font.glyphs =
+      LoadFontData(fileData, fileSize, SDF_FONT_SIZE, codepoints, codepointCount, FONT_SDF);
+  UnloadFileData(fileData);
+
+  if (font.glyphs == NULL) {
+    TraceLog(LOG_WARNING, "RayAnim: Failed to load SDF font %s", filename);
+    return 0;
+  }
+
+  Image atlas = GenImageFontAtlas(font.glyphs, &font.recs, font.glyphCount, SDF_FONT_SIZE, 0, 1);
+  font.texture = LoadTextureFromImage(atlas);
+  SetTextureFilter(font.texture, TEXTURE_FILTER_BILINEAR);
+  UnloadImage(atlas);
+
+  fonts[fontCount] = font;
+  sdfFonts[fontCount] = true;
+  setAssetFilename(fontFilenames[fontCount], filename);
+  fontIdentities[fontCount] = identity;
+  trackFont(font);
+
+  return fontCount++;
+}
+
+void setSdfFontForText(RAText *text, char *filename) {
+  text->fontIdx = loadSdfFont(filename, NULL, 0);
+}
+
+void initTextAnimation(Animation *anim,
+                       RAText *text,
+                       float duration,
+                       bool (*update)(void *, double),
+                       void (*interpolate)(void *, float)) {
+  initAnimation(
+      anim, (RAObject *)text, duration, update, interpolate, pushToObjectsDefaultAnimation);
+}
 
-  float x = rect->base.position.x;
-  float y = rect->base.position.y;
-  float width = rect->width;
-  float height = rect->height;
-  float halfThickness = rect->outlineThickness / 2.0f;
-  float thickness = rect->outlineThickness;
-  float firstQuarter = rect->firstQuarter;
-  float secondQuarter = rect->secondQuarter;
-  float thirdQuarter = rect->thirdQuarter;
-  float lastQuarter = rect->lastQuarter;
+void initDefaultTextAnimation(Animation *anim, RAText *text) {
+  initTextAnimation(anim,
+                    text,
+                    text->charRevealTime * strlen(text->fullText),
+                    updateDefaultAnimation,
+                    interpolateDefaultTextAnimation);
+}
 
-  DrawLineEx((Vector2){x, y + halfThickness},
-             (Vector2){x + (width - thickness) * firstQuarter, y + halfThickness},
-             thickness,
-             rect->outlineColor);
+Animation createTextAnimation(RAText *text) {
+  Animation anim;
+  initDefaultTextAnimation(&anim, text);
+  return anim;
+}
 
-  DrawLineEx((Vector2){x + width - halfThickness, y},
-             (Vector2){x + width - halfThickness, y + (height - thickness) * secondQuarter},
-             thickness,
-             rect->outlineColor);
+void interpolateDefaultTextAnimation(void *self, float time) {
+  (void)time;
+  Animation *anim = (Animation *)self;
+  RAText *text = (RAText *)anim->object;
 
-  DrawTriangle((Vector2){x + thickness, y + thickness},
-               (Vector2){x + width - thickness, y + (height - thickness) * secondQuarter},
-               (Vector2){x + width - thickness, y + thickness},
-               rect->base.color);
+  size_t revealed = (size_t)(anim->elapsedTime / text->charRevealTime) + 1;
+  size_t maxCount = strlen(text->fullText) + 1;
+  text->displayCharCount = revealed < maxCount ? revealed : maxCount;
+}
 
-  DrawLineEx(
-      (Vector2){x + width, y + height - halfThickness},
-      (Vector2){(x + width) - (width - thickness) * thirdQuarter, y + height - halfThickness},
-      thickness,
-      rect->outlineColor);
+// ---------------- RAText ----------------
 
-  DrawTriangle((Vector2){x + thickness, y + thickness},
-               (Vector2){(x + width) - (width - thickness) * thirdQuarter, y + height - thickness},
-               (Vector2){x + width - thickness, y + height - thickness},
-               rect->base.color);
+// --------------- RAImage ----------------
 
-  DrawLineEx((Vector2){x + halfThickness, y + height},
-             (Vector2){x + halfThickness, (y + height) - (height - thickness) * lastQuarter},
-             thickness,
-             rect->outlineColor);
+typedef struct ProxyImageHeader {
+  uint32_t magic;
+  int32_t width;
+  int32_t height;
+  int32_t proxyWidth;
+  int32_t proxyHeight;
+  int32_t size;
+} ProxyImageHeader;
+
+// Proxies are keyed by the source's path, modification time and the proxy scale, so editing the
+// source or changing the scale regenerates them.
+static void getProxyImagePath(const char *filename, char *path, size_t size) {
+  long modTime = GetFileModTime(filename);
+  RAHash hash = hashBytes(FNV_OFFSET_BASIS, filename, strlen(filename));
+  hash = hashBytes(hash, &modTime, sizeof(modTime));
+  hash = hashBytes(hash, &proxyScale, sizeof(proxyScale));
+
+  snprintf(path, size, "%s/%016llx.proxy", proxyCacheDir, (unsigned long long)hash);
 }
 
-void initRectangleAnimation(Animation *anim,
-                            RARectangle *rect,
-                            float duration,
-                            bool (*update)(void *, float),
-                            void (*interpolate)(void *, float)) {
+static bool loadCachedProxyImage(const char *path, Image *proxy, int *width, int *height) {
+  if (!FileExists(path)) return false;
+
+  int fileSize = 0;
+  unsigned char *data = LoadFileData(path, &fileSize);
+  if (data == NULL) return false;
+
+  ProxyImageHeader header;
+  bool valid = fileSize >= (int)sizeof(header);
+  if (valid) {
+    memcpy(&header, data, sizeof(header));
+    valid = (header.magic == PROXY_IMAGE_MAGIC) && (header.size == fileSize - (int)sizeof(header));
+  }
+
+  if (valid) {
+    *proxy = GenImageColor(header.proxyWidth, header.proxyHeight, BLANK);
+    valid = decompressLz4Block(data + sizeof(header),
+                               header.size,
+                               proxy->data,
+                               header.proxyWidth * header.proxyHeight * 4);
+    if (!valid) UnloadImage(*proxy);
+  }
+  UnloadFileData(data);
+
+  if (valid) {
+    *width = header.width;
+    *height = header.height;
+  }
+  return valid;
+}
+
+static void saveProxyImage(const char *path, Image proxy, int width, int height) {
+  int size = proxy.width * proxy.height * 4;
+  unsigned char *data =
+      allocateMemory(MEMORY_TEXTURES, sizeof(ProxyImageHeader) + size + size / 255 + 16);
+  assert(data != NULL);
+
+  ProxyImageHeader header = {PROXY_IMAGE_MAGIC, width, height, proxy.width, proxy.height, 0};
+  header.size = compressLz4Block(proxy.data, size, data + sizeof(header));
+  memcpy(data, &header, sizeof(header));
+
+  if (!SaveFileData(path, data, sizeof(header) + header.size))
+    TraceLog(LOG_WARNING, "RayAnim: Could not write proxy image %s", path);
+  releaseMemory(data);
+}
+
+// The proxy is downsampled from the premultiplied source once and then read back from the cache.
+static TextureIndex loadProxyTexture(const char *filename) {
+  char path[1024];
+  Image proxy;
+  int width;
+  int height;
+
+  if (proxyCacheDir != NULL) getProxyImagePath(filename, path, sizeof(path));
+  if ((proxyCacheDir == NULL) || !loadCachedProxyImage(path, &proxy, &width, &height)) {
+    Image source = LoadImage(filename);
+    ImageFormat(&source, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    ImageAlphaPremultiply(&source);
+    width = source.width;
+    height = source.height;
+
+    int proxyWidth = (int)ceilf(width * proxyScale);
+    int proxyHeight = (int)ceilf(height * proxyScale);
+    proxy = GenImageColor(proxyWidth, proxyHeight, BLANK);
+    downscaleImage(source, &proxy);
+    UnloadImage(source);
+
+    if (proxyCacheDir != NULL) {
+      mkdir(proxyCacheDir, 0755);
+      saveProxyImage(path, proxy, width, height);
+    }
+  }
+
+  TextureIndex textureIdx = loadTextureWithMipmaps(proxy);
+  textures[textureIdx].width = width;
+  textures[textureIdx].height = height;
+  UnloadImage(proxy);
+
+  return textureIdx;
+}
+
+void initImage(
+    RAImage *image, char *filename, Vector2 pos, float scale, Color tint, void (*render)(void *)) {
+  initRAObject(&image->base, pos, tint, render);
+  image->base.hash = hashDefaultImage;
+  image->base.bounds = boundsDefaultImage;
+  image->filename = filename;
+  image->scale = scale;
+
+  // The scale is part of the identity, so proxies and full-resolution textures are not mixed up.
+  RAHash identity = getAssetIdentity(filename, &proxyScale, sizeof(proxyScale));
+  image->textureIdx = findLoadedTexture(filename, identity);
+  if (image->textureIdx >= 0) return;
+
+  if (proxyScale < 1.0f) {
+    image->textureIdx = loadProxyTexture(filename);
+  } else {
+    Image source = LoadImage(filename);
+    ImageAlphaPremultiply(&source);
+    image->textureIdx = loadTextureWithMipmaps(source);
+    UnloadImage(source);
+  }
+  setAssetFilename(textureFilenames[image->textureIdx], filename);
+  textureIdentities[image->textureIdx] = identity;
+}
+
+void initDefaultImage(RAImage *image, char *filename, Vector2 pos) {
+  initImage(image, filename, pos, 1.0f, RAYWHITE, renderDefaultImage);
+}
+
+RAImage createImage(char *filename, Vector2 pos) {
+  RAImage image;
+  initDefaultImage(&image, filename, pos);
+  return image;
+}
+
+void renderDefaultImage(void *self) {
+  RAImage *image = (RAImage *)self;
+  RATexture *texture = &textures[image->textureIdx];
+  Color tint = resolveRAObjectColor(&image->base, image->base.color);
+
+  // Proxy textures are smaller than the image they stand in for, and a proxy target shrinks
+  // whatever is drawn into it.
+  float sourceScale = image->scale * texture->width / texture->levels[0].width;
+  int levelIdx = selectTextureLevel(texture, sourceScale * renderScale);
+  float levelScale = sourceScale * texture->levels[0].width / texture->levels[levelIdx].width;
+
+  emitTexture(image->textureIdx, levelIdx, image->base.position, levelScale, tint);
+}
+
+Rectangle boundsDefaultImage(void *self) {
+  RAImage *image = (RAImage *)self;
+  RATexture *texture = &textures[image->textureIdx];
+
+  return (Rectangle){image->base.position.x,
+                     image->base.position.y,
+                     texture->width * image->scale,
+                     texture->height * image->scale};
+}
+
+// The whole chain is built once at load time so that drawing a downscaled image only samples
+// about as many texels as it covers on screen. source is premultiplied, so every level is built
+// with downscaleImage() rather than ImageResize(), which treats alpha as straight.
+TextureIndex loadTextureWithMipmaps(Image source) {
+  // Unlike texts, images have nothing to fall back to.
+  assert(textureCount < MAX_LOADED_ASSETS);
+
+  RATexture *texture = &textures[textureCount];
+  Image level = ImageCopy(source);
+  ImageFormat(&level, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+  textureFilenames[textureCount][0] = '\0';
+  textureIdentities[textureCount] = 0;
+  texture->width = source.width;
+  texture->height = source.height;
+
+  texture->levels[0] = LoadTextureFromImage(level);
+  texture->levelCount = 1;
+  trackMemory(MEMORY_TEXTURES, getTextureMemory(texture->levels[0]));
+
+  while (((level.width > 1) || (level.height > 1)) && (texture->levelCount < MAX_MIP_LEVELS)) {
+    int width = level.width > 1 ? level.width / 2 : 1;
+    int height = level.height > 1 ? level.height / 2 : 1;
+    Image next = GenImageColor(width, height, BLANK);
+    downscaleImage(level, &next);
+    UnloadImage(level);
+    level = next;
+
+    texture->levels[texture->levelCount] = LoadTextureFromImage(level);
+    SetTextureFilter(texture->levels[texture->levelCount], TEXTURE_FILTER_BILINEAR);
+    trackMemory(MEMORY_TEXTURES, getTextureMemory(texture->levels[texture->levelCount]));
+    texture->levelCount++;
+  }
+
+  SetTextureFilter(texture->levels[0], TEXTURE_FILTER_BILINEAR);
+  UnloadImage(level);
+
+  return textureCount++;
+}
+
+int selectTextureLevel(RATexture *texture, float scale) {
+  if (scale >= 1.0f) return 0;
+  if (scale <= 0.0f) return texture->levelCount - 1;
+
+  int level = (int)floorf(log2f(1.0f / scale));
+  return level < texture->levelCount ? level : texture->levelCount - 1;
+}
+
+RAHash hashDefaultImage(void *self, RAHash hash) {
+  RAImage *image = (RAImage *)self;
+
+  if (textureIdentities[image->textureIdx] == 0) markFrameUncacheable();
+
+  hash = hashRAObjectBase(&image->base, hash);
+  hash = hashBytes(hash, &textureIdentities[image->textureIdx], sizeof(RAHash));
+  hash = hashBytes(hash, &image->scale, sizeof(image->scale));
+
+  return hash;
+}
+
+void initImageAnimation(Animation *anim,
+                        RAImage *image,
+                        float duration,
+                        bool (*update)(void *, double),
+                        void (*interpolate)(void *, float)) {
   initAnimation(
-      anim, (RAObject *)rect, duration, update, interpolate, pushToObjectsDefaultAnimation);
+      anim, (RAObject *)image, duration, update, interpolate, pushToObjectsDefaultAnimation);
 }
 
-void initDefaultRectangleAnimation(Animation *anim, RARectangle *rect) {
-  initRectangleAnimation(
-      anim, rect, 0.7, updateDefaultAnimation, interpolateDefaultRectangleAnimation);
+void initDefaultImageAnimation(Animation *anim, RAImage *image) {
+  initImageAnimation(anim, image, 0.8f, updateDefaultAnimation, interpolateDefaultImageAnimation);
 }
 
-Animation createRectangleAnimation(RARectangle *rect) {
+Animation createImageAnimation(RAImage *image) {
   Animation anim;
-  initDefaultRectangleAnimation(&anim, rect);
+  initDefaultImageAnimation(&anim, image);
   return anim;
 }
 
-void interpolateDefaultRectangleAnimation(void *self, float time) {
-  (void)time;
+void interpolateDefaultImageAnimation(void *self, float time) {
+  Animation *anim = (Animation *)self;
+  RAImage *image = (RAImage *)anim->object;
+  image->base.opacity = time;
+}
+
+// --------------- RAImage ----------------
+
+// --------------- RAGroup ----------------
+
+void initGroup(
+    RAGroup *group, Vector2 position, float rotation, Vector2 scale, void (*render)(void *)) {
+  initRAObject(&group->base, position, WHITE, render);
+  group->base.hash = hashDefaultGroup;
+  group->base.bounds = boundsDefaultGroup;
+  initRAObjects(&group->children);
+  group->rotation = rotation;
+  group->scale = scale;
+
+  group->localTransform = MatrixIdentity();
+  group->worldTransform = MatrixIdentity();
+  group->version = 0;
+  group->parentVersion = 0;
+  group->transformRevision = 0;
+}
+
+void initDefaultGroup(RAGroup *group, Vector2 position) {
+  initGroup(group, position, 0.0f, (Vector2){1.0f, 1.0f}, renderDefaultGroup);
+}
+
+RAGroup createGroup(Vector2 position) {
+  RAGroup group;
+  initDefaultGroup(&group, position);
+  return group;
+}
+
+void addToGroup(RAGroup *group, RAObject *obj) {
+  assert((obj != &group->base) && (obj->parent == NULL));
 
+  obj->parent = &group->base;
+  pushToRAObjects(&group->children, obj);
+  markRAObjectDirty(&group->base);
+}
+
+void updateGroupTransform(RAGroup *group) {
+  RAGroup *parent = (RAGroup *)group->base.parent;
+  if (parent != NULL) updateGroupTransform(parent);
+
+  bool parentChanged = (parent != NULL) && (parent->version != group->parentVersion);
+  bool localChanged = group->base.localRevision != group->transformRevision;
+  if (!localChanged && !parentChanged) return;
+
+  if (localChanged) {
+    Matrix scale = MatrixScale(group->scale.x, group->scale.y, 1.0f);
+    Matrix rotation = MatrixRotateZ(group->rotation * DEG2RAD);
+    Matrix translation = MatrixTranslate(group->base.position.x, group->base.position.y, 0.0f);
+    group->localTransform = MatrixMultiply(MatrixMultiply(scale, rotation), translation);
+  }
+
+  if (parent != NULL) {
+    group->worldTransform = MatrixMultiply(group->localTransform, parent->worldTransform);
+    group->parentVersion = parent->version;
+  } else {
+    group->worldTransform = group->localTransform;
+  }
+
+  group->version++;
+  group->transformRevision = group->base.localRevision;
+}
+
+void renderDefaultGroup(void *self) {
+  RAGroup *group = (RAGroup *)self;
+  updateGroupTransform(group);
+
+  emitPushTransform(group->localTransform);
+
+  for (int i = 0; i < group->children.count; i++) {
+    RAObject *child = getFromRAObjects(&group->children, i);
+    if (child->opacity > 0.0f) renderRAObject(child);
+  }
+
+  flushBatch();
+  emitPopTransform();
+}
+
+// Children report bounds in the group's space; the union of their transformed corners gives the
+// group's bounds in its parent's space.
+Rectangle boundsDefaultGroup(void *self) {
+  RAGroup *group = (RAGroup *)self;
+  updateGroupTransform(group);
+
+  float minX = FLT_MAX;
+  float minY = FLT_MAX;
+  float maxX = -FLT_MAX;
+  float maxY = -FLT_MAX;
+
+  for (int i = 0; i < group->children.count; i++) {
+    RAObject *child = getFromRAObjects(&group->children, i);
+    Rectangle bounds = child->bounds(child);
+    if (isBoundsUnbounded(bounds)) return bounds;
+
+    Vector2 corners[4] = {{bounds.x, bounds.y},
+                          {bounds.x + bounds.width, bounds.y},
+                          {bounds.x, bounds.y + bounds.height},
+                          {bounds.x + bounds.width, bounds.y + bounds.height}};
+
+    for (int j = 0; j < 4; j++) {
+      Vector2 corner = Vector2Transform(corners[j], group->localTransform);
+      minX = fminf(minX, corner.x);
+      minY = fminf(minY, corner.y);
+      maxX = fmaxf(maxX, corner.x);
+      maxY = fmaxf(maxY, corner.y);
+    }
+  }
+
+  if (minX > maxX) return (Rectangle){group->base.position.x, group->base.position.y, 0, 0};
+
+  return (Rectangle){minX, minY, maxX - minX, maxY - minY};
+}
+
+RAHash hashDefaultGroup(void *self, RAHash hash) {
+  RAGroup *group = (RAGroup *)self;
+
+  hash = hashRAObjectBase(&group->base, hash);
+  hash = hashBytes(hash, &group->rotation, sizeof(group->rotation));
+  hash = hashBytes(hash, &group->scale, sizeof(group->scale));
+
+  for (int i = 0; i < group->children.count; i++) {
+    RAObject *child = getFromRAObjects(&group->children, i);
+    hash = child->hash(child, hash);
+  }
+
+  return hash;
+}
+
+void destroyGroup(RAGroup *group) {
+  for (int i = 0; i < group->children.count; i++)
+    getFromRAObjects(&group->children, i)->parent = NULL;
+
+  destroyRAObjects(&group->children);
+}
+
+void initGroupAnimation(Animation *anim,
+                        RAGroup *group,
+                        float duration,
+                        bool (*update)(void *, double),
+                        void (*interpolate)(void *, float)) {
+  initAnimation(
+      anim, (RAObject *)group, duration, update, interpolate, pushToObjectsDefaultAnimation);
+}
+
+void initDefaultGroupAnimation(Animation *anim, RAGroup *group) {
+  initGroupAnimation(anim, group, 0.8f, updateDefaultAnimation, interpolateDefaultGroupAnimation);
+}
+
+Animation createGroupAnimation(RAGroup *group) {
+  Animation anim;
+  initDefaultGroupAnimation(&anim, group);
+  return anim;
+}
+
+void interpolateDefaultGroupAnimation(void *self, float time) {
   Animation *anim = (Animation *)self;
-  RARectangle *rect = (RARectangle *)anim->object;
+  anim->object->opacity = time;
+}
 
-  float elapsedTime = anim->elapsedTime;
-  float quarterDuration = anim->duration / 4.0f;
+// --------------- RAGroup ----------------
 
-  rect->firstQuarter = fminf(elapsedTime / quarterDuration, 1.0f);
+// ------------- RAParticles --------------
 
-  if ((elapsedTime - quarterDuration) > 0)
-    rect->secondQuarter = fminf((elapsedTime - quarterDuration) / quarterDuration, 1.0f);
+void initParticles(RAParticles *particles,
+                   Vector2 emitter,
+                   int capacity,
+                   float emissionRate,
+                   float lifetime,
+                   float speed,
+                   float size,
+                   Color color,
+                   void (*render)(void *)) {
+  assert(capacity > 0);
+
+  initRAObject(&particles->base, emitter, color, render);
+  particles->base.hash = hashDefaultParticles;
+  particles->base.bounds = boundsDefaultParticles;
+
+  particles->capacity = capacity;
+  particles->x = allocateMemory(MEMORY_OBJECTS, capacity * sizeof(float));
+  particles->y = allocateMemory(MEMORY_OBJECTS, capacity * sizeof(float));
+  particles->vx = allocateMemory(MEMORY_OBJECTS, capacity * sizeof(float));
+  particles->vy = allocateMemory(MEMORY_OBJECTS, capacity * sizeof(float));
+  particles->life = allocateMemory(MEMORY_OBJECTS, capacity * sizeof(float));
+  particles->colors = allocateMemory(MEMORY_OBJECTS, capacity * sizeof(Color));
+  assert((particles->x != NULL) && (particles->y != NULL) && (particles->vx != NULL) &&
+         (particles->vy != NULL) && (particles->life != NULL) && (particles->colors != NULL));
+
+  particles->emissionRate = emissionRate;
+  particles->lifetime = lifetime;
+  particles->speed = speed;
+  particles->size = size;
+  particles->gravity = (Vector2){0.0f, 0.0f};
+
+  resetParticles(particles);
+}
 
-  if ((elapsedTime - quarterDuration * 2) > 0)
-    rect->thirdQuarter = fminf((elapsedTime - quarterDuration * 2) / quarterDuration, 1.0f);
+// Kills every particle and restarts the seed, so a replay emits the same particles.
+void resetParticles(RAParticles *particles) {
+  particles->count = 0;
+  particles->seed = 0x9E3779B9u;
+  particles->lastTime = 0.0;
+  particles->emissionAccumulator = 0.0;
+  particles->extent = (Rectangle){particles->base.position.x, particles->base.position.y, 0, 0};
+  markRAObjectDirty(&particles->base);
+}
 
-  if ((elapsedTime - quarterDuration * 3) > 0)
-    rect->lastQuarter = fminf((elapsedTime - quarterDuration * 3) / quarterDuration, 1.0f);
+void initDefaultParticles(RAParticles *particles, Vector2 emitter, int capacity) {
+  initParticles(
+      particles, emitter, capacity, 2000.0f, 1.0f, 400.0f, 6.0f, ORANGE, renderDefaultParticles);
 }
 
-// ------------- RARectangle --------------
+RAParticles createParticles(Vector2 emitter, int capacity) {
+  RAParticles particles;
+  initDefaultParticles(&particles, emitter, capacity);
+  return particles;
+}
 
-// -------------- RASquare ----------------
+static float nextParticleRandom(RAParticles *particles) {
+  uint32_t seed = particles->seed;
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  particles->seed = seed;
 
-void initSquare(RARectangle *square,
-                Vector2 position,
-                float length,
-                float outlineThickness,
-                Color innerColor,
-                Color outlineColor,
-                void (*render)(void *)) {
-  initRectangle(
-      square, position, length, length, outlineThickness, innerColor, outlineColor, render);
+  return (seed >> 8) * (1.0f / 16777216.0f);
 }
 
-void initDefaultSquare(RARectangle *square, Vector2 position, float length) {
-  initDefaultRectangle(square, position, length, length);
+static void emitParticles(RAParticles *particles, int emitCount) {
+  for (int i = 0; (i < emitCount) && (particles->count < particles->capacity); i++) {
+    int idx = particles->count++;
+    float angle = nextParticleRandom(particles) * 2.0f * PI;
+    float speed = particles->speed * (0.5f + 0.5f * nextParticleRandom(particles));
+
+    particles->x[idx] = particles->base.position.x;
+    particles->y[idx] = particles->base.position.y;
+    particles->vx[idx] = cosf(angle) * speed;
+    particles->vy[idx] = sinf(angle) * speed;
+    particles->life[idx] = particles->lifetime;
+    particles->colors[idx] = particles->base.color;
+  }
 }
 
-RARectangle createSquare(Vector2 position, float length) {
-  RARectangle square;
-  initDefaultSquare(&square, position, length);
-  return square;
+// Advances the pool to an absolute time. The per-field loops are kept free of branches so the
+// compiler can vectorize them; dead particles are then swapped out of the live range.
+void stepParticles(RAParticles *particles, double time, bool emit) {
+  float dt = (float)(time - particles->lastTime);
+  if (dt <= 0.0f) return;
+
+  particles->lastTime = time;
+
+  int count = particles->count;
+  float gx = particles->gravity.x * dt;
+  float gy = particles->gravity.y * dt;
+  float *restrict x = particles->x;
+  float *restrict y = particles->y;
+  float *restrict vx = particles->vx;
+  float *restrict vy = particles->vy;
+  float *restrict life = particles->life;
+
+  for (int i = 0; i < count; i++) vx[i] += gx;
+  for (int i = 0; i < count; i++) vy[i] += gy;
+  for (int i = 0; i < count; i++) x[i] += vx[i] * dt;
+  for (int i = 0; i < count; i++) y[i] += vy[i] * dt;
+  for (int i = 0; i < count; i++) life[i] -= dt;
+
+  for (int i = 0; i < particles->count;) {
+    if (life[i] > 0.0f) {
+      i++;
+      continue;
+    }
+
+    int last = --particles->count;
+    x[i] = x[last];
+    y[i] = y[last];
+    vx[i] = vx[last];
+    vy[i] = vy[last];
+    life[i] = life[last];
+    particles->colors[i] = particles->colors[last];
+  }
+
+  if (emit) {
+    particles->emissionAccumulator += particles->emissionRate * dt;
+    int emitCount = (int)particles->emissionAccumulator;
+    particles->emissionAccumulator -= emitCount;
+    emitParticles(particles, emitCount);
+  }
+
+  float minX = particles->base.position.x;
+  float minY = particles->base.position.y;
+  float maxX = minX;
+  float maxY = minY;
+
+  for (int i = 0; i < particles->count; i++) {
+    minX = fminf(minX, x[i]);
+    minY = fminf(minY, y[i]);
+    maxX = fmaxf(maxX, x[i]);
+    maxY = fmaxf(maxY, y[i]);
+  }
+
+  float halfSize = particles->size / 2;
+  particles->extent = (Rectangle){minX - halfSize,
+                                  minY - halfSize,
+                                  maxX - minX + particles->size,
+                                  maxY - minY + particles->size};
+  markRAObjectDirty(&particles->base);
 }
 
-// -------------- RASquare ----------------
+// Particles are written straight into the triangle batch as one quad each.
+void renderDefaultParticles(void *self) {
+  RAParticles *particles = (RAParticles *)self;
+  float opacity = getRAObjectOpacity(&particles->base);
+  float halfSize = particles->size / 2;
+
+  reserveBatch(6 * particles->count);
+  Vector2 *vertices = getBatchVertices();
+  Color *colors = getBatchColors();
+  int written = 0;
+
+  for (int i = 0; i < particles->count; i++) {
+    Color color = premultiplyColor(particles->colors[i],
+                                   opacity * particles->life[i] / particles->lifetime);
+    if (color.a == 0) continue;
+
+    float left = particles->x[i] - halfSize;
+    float top = particles->y[i] - halfSize;
+    float right = particles->x[i] + halfSize;
+    float bottom = particles->y[i] + halfSize;
+
+    Vector2 *quad = vertices + written;
+    quad[0] = (Vector2){left, top};
+    quad[1] = (Vector2){left, bottom};
+    quad[2] = (Vector2){right, bottom};
+    quad[3] = (Vector2){left, top};
+    quad[4] = (Vector2){right, bottom};
+    quad[5] = (Vector2){right, top};
+
+    for (int j = 0; j < 6; j++) colors[written + j] = color;
+    written += 6;
+  }
 
-// ---------------- RADelay ----------------
+  commitBatch(written);
+}
 
-static RAObject wait_object;
+RAHash hashDefaultParticles(void *self, RAHash hash) {
+  RAParticles *particles = (RAParticles *)self;
 
-void initDelayAnimation(Animation *anim, float duration) {
-  initEmptyRAObject(&wait_object);
-  initAnimation(anim,
-                &wait_object,
-                duration,
-                updateDefaultAnimation,
-                interpolateDelayAnimation,
-                pushToObjectsDefaultAnimation);
+  hash = hashRAObjectBase(&particles->base, hash);
+  hash = hashBytes(hash, &particles->size, sizeof(particles->size));
+  hash = hashBytes(hash, &particles->count, sizeof(particles->count));
+  hash = hashBytes(hash, particles->x, particles->count * sizeof(float));
+  hash = hashBytes(hash, particles->y, particles->count * sizeof(float));
+  hash = hashBytes(hash, particles->life, particles->count * sizeof(float));
+  hash = hashBytes(hash, particles->colors, particles->count * sizeof(Color));
+
+  return hash;
 }
 
-Animation createDelayAnimation(float duration) {
+Rectangle boundsDefaultParticles(void *self) {
+  RAParticles *particles = (RAParticles *)self;
+  return particles->extent;
+}
+
+void destroyParticles(RAParticles *particles) {
+  releaseMemory(particles->x);
+  releaseMemory(particles->y);
+  releaseMemory(particles->vx);
+  releaseMemory(particles->vy);
+  releaseMemory(particles->life);
+  releaseMemory(particles->colors);
+  particles->count = 0;
+}
+
+void initParticlesAnimation(Animation *anim,
+                            RAParticles *particles,
+                            float duration,
+                            bool (*update)(void *, double),
+                            void (*interpolate)(void *, float)) {
+  initAnimation(
+      anim, (RAObject *)particles, duration, update, interpolate, pushToObjectsDefaultAnimation);
+  anim->reset = resetDefaultParticlesAnimation;
+}
+
+void initDefaultParticlesAnimation(Animation *anim, RAParticles *particles) {
+  initParticlesAnimation(
+      anim, particles, 3.0f, updateDefaultAnimation, interpolateDefaultParticlesAnimation);
+}
+
+Animation createParticlesAnimation(RAParticles *particles) {
   Animation anim;
-  initDelayAnimation(&anim, duration);
+  initDefaultParticlesAnimation(&anim, particles);
   return anim;
 }
 
-void interpolateDelayAnimation(void *self, float time) {
-  (void)time;
-  (void)self;
+// Emission stops one lifetime before the end so the last particles have died out by then.
+void interpolateDefaultParticlesAnimation(void *self, float time) {
+  (void)time;
+
+  Animation *anim = (Animation *)self;
+  RAParticles *particles = (RAParticles *)anim->object;
+  bool emit = anim->elapsedTime < anim->duration - particles->lifetime;
+
+  stepParticles(particles, anim->elapsedTime, emit);
+}
+
+void resetDefaultParticlesAnimation(void *self) {
+  resetParticles((RAParticles *)((Animation *)self)->object);
+}
+
+// ------------- RAParticles --------------
+
+// ---------------- RAPath ----------------
+
+DEFINE_VECTOR(PathPoints, PathPoint, points, MEMORY_OBJECTS)
+DEFINE_VECTOR(PathVertices, Vector2, vertices, MEMORY_OBJECTS)
+DEFINE_VECTOR(PathOffsets, int, offsets, MEMORY_OBJECTS)
+
+// Curves are flattened into a polyline as they are added, together with a cumulative arc-length
+// table and the triangles of the full stroke. Drawing a partial reveal is a binary search for
+// the cut point, a copy of the stroke prefix and one partial segment.
+
+void initPath(
+    RAPath *path, Vector2 position, float thickness, Color color, void (*render)(void *)) {
+  initRAObject(&path->base, position, color, render);
+  path->base.hash = hashDefaultPath;
+  path->base.bounds = boundsDefaultPath;
+
+  initPathPoints(&path->points);
+  path->geometryHash = FNV_OFFSET_BASIS;
+  path->extent = (Rectangle){0, 0, 0, 0};
+
+  path->thickness = thickness;
+  path->reveal = 0.0f;
+
+  initPathVertices(&path->strokeVertices);
+  initPathOffsets(&path->strokeOffsets);
+  path->strokeThickness = -1.0f;
+}
+
+void initDefaultPath(RAPath *path, Vector2 position) {
+  initPath(path, position, 12.0f, DARKGRAY, renderDefaultPath);
 }
 
-// ---------------- RADelay ----------------
+RAPath createPath(Vector2 position) {
+  RAPath path;
+  initDefaultPath(&path, position);
+  return path;
+}
 
-// ---------------- FadeOut ----------------
+static void appendPathPoint(RAPath *path, Vector2 point, bool penDown) {
+  int count = path->points.count;
+  float length = 0.0f;
 
-void initFadeOutAnimation(Animation *anim,
-                          RAObject *obj,
-                          float duration,
-                          bool (*update)(void *, float),
-                          void (*interpolate)(void *, float)) {
-  initAnimation(anim, obj, duration, update, interpolate, pushToObjectsDefaultAnimation);
+  if (count > 0) {
+    PathPoint last = path->points.points[count - 1];
+    length = last.length;
+    if (penDown) length += Vector2Distance(last.position, point);
+  } else {
+    penDown = false;
+    path->extent = (Rectangle){point.x, point.y, 0, 0};
+  }
+
+  pushToPathPoints(&path->points, (PathPoint){point, length, penDown});
+
+  float maxX = fmaxf(path->extent.x + path->extent.width, point.x);
+  float maxY = fmaxf(path->extent.y + path->extent.height, point.y);
+  path->extent.x = fminf(path->extent.x, point.x);
+  path->extent.y = fminf(path->extent.y, point.y);
+  path->extent.width = maxX - path->extent.x;
+  path->extent.height = maxY - path->extent.y;
+
+  path->geometryHash = hashBytes(path->geometryHash, &point, sizeof(point));
+  path->geometryHash = hashBytes(path->geometryHash, &penDown, sizeof(penDown));
+  path->strokeThickness = -1.0f;
+  markRAObjectDirty(&path->base);
 }
 
-void initDefaultFadeOutAnimation(Animation *anim, RAObject *obj) {
-  initFadeOutAnimation(anim, obj, 1.0f, updateDefaultAnimation, interpolateDefaultFadeOutAnimation);
+static Vector2 getLastPathPoint(RAPath *path) {
+  assert(path->points.count > 0);
+  return path->points.points[path->points.count - 1].position;
 }
 
-Animation createFadeOutAnimation(RAObject *obj) {
-  Animation anim;
-  initDefaultFadeOutAnimation(&anim, obj);
-  return anim;
+static int getCurveSegmentCount(float controlLength) {
+  int segments = (int)ceilf(controlLength / 8.0f);
+  return segments < 4 ? 4 : (segments > 256 ? 256 : segments);
 }
 
-void interpolateDefaultFadeOutAnimation(void *self, float time) {
-  Animation *anim = (Animation *)self;
-  anim->object->color.a = 255 - (unsigned char)(255 * time);
+void pathMoveTo(RAPath *path, Vector2 point) {
+  appendPathPoint(path, point, false);
 }
 
-// ---------------- FadeOut ----------------
+void pathLineTo(RAPath *path, Vector2 point) {
+  appendPathPoint(path, point, true);
+}
 
-// ----------------- Sync ------------------
+void pathQuadraticTo(RAPath *path, Vector2 control, Vector2 end) {
+  Vector2 start = getLastPathPoint(path);
+  int segments =
+      getCurveSegmentCount(Vector2Distance(start, control) + Vector2Distance(control, end));
 
-void initSyncAnimation(SyncAnimation *anim,
-                       Animation **anims,
-                       int animCount,
-                       void (*pushToObjects)(Scene *)) {
-  initAnimation((Animation *)anim,
-                NULL,
-                0,
-                updateDefaultSyncAnimation,
-                interpolateDefaultSyncAnimation,
-                pushToObjects);
-  anim->animations = anims;
-  anim->animCount = animCount;
+  for (int i = 1; i <= segments; i++) {
+    float t = (float)i / segments;
+    float u = 1.0f - t;
+
+    Vector2 point = {u * u * start.x + 2 * u * t * control.x + t * t * end.x,
+                     u * u * start.y + 2 * u * t * control.y + t * t * end.y};
+    appendPathPoint(path, point, true);
+  }
 }
 
-void initDefaultSyncAnimation(SyncAnimation *anim, Animation **anims, int animCount) {
-  initSyncAnimation(anim, anims, animCount, pushToObjectsDefaultSyncAnimation);
+void pathCubicTo(RAPath *path, Vector2 control1, Vector2 control2, Vector2 end) {
+  Vector2 start = getLastPathPoint(path);
+  int segments = getCurveSegmentCount(Vector2Distance(start, control1) +
+                                      Vector2Distance(control1, control2) +
+                                      Vector2Distance(control2, end));
+
+  for (int i = 1; i <= segments; i++) {
+    float t = (float)i / segments;
+    float u = 1.0f - t;
+    float a = u * u * u;
+    float b = 3 * u * u * t;
+    float c = 3 * u * t * t;
+    float d = t * t * t;
+
+    Vector2 point = {a * start.x + b * control1.x + c * control2.x + d * end.x,
+                     a * start.y + b * control1.y + c * control2.y + d * end.y};
+    appendPathPoint(path, point, true);
+  }
 }
 
-SyncAnimation createSyncAnimation(Animation **anims, int animCount) {
-  SyncAnimation anim;
-  initDefaultSyncAnimation(&anim, anims, animCount);
-  return anim;
+float getPathLength(RAPath *path) {
+  int count = path->points.count;
+  return count > 0 ? path->points.points[count - 1].length : 0.0f;
 }
 
-bool updateDefaultSyncAnimation(void *self, float dt) {
-  SyncAnimation *anim = (SyncAnimation *)self;
+// The left and right corners of a square segment end at `point`.
+static void getPathEdge(Vector2 *edge, Vector2 point, Vector2 direction, float halfThickness) {
+  Vector2 normal = {-direction.y * halfThickness, direction.x * halfThickness};
+  edge[0] = Vector2Add(point, normal);
+  edge[1] = Vector2Subtract(point, normal);
+}
 
-  if (anim->base.done) return true;
+static Vector2 getPathDirection(Vector2 from, Vector2 to) {
+  return Vector2Normalize(Vector2Subtract(to, from));
+}
 
-  int completedNum = 0;
+static int strokePathSegment(Vector2 *out, Vector2 *start, Vector2 *end) {
+  out[0] = start[0];
+  out[1] = start[1];
+  out[2] = end[1];
+  out[3] = start[0];
+  out[4] = end[1];
+  out[5] = end[0];
+
+  orientTriangle(out);
+  orientTriangle(out + 3);
+  return 6;
+}
 
-  for (int i = 0; i < anim->animCount; i++) {
-    Animation *each = anim->animations[i];
+// Bevel join. The segments meeting at `joint` end and start on the point where their inner
+// edges cross, and one triangle fills the wedge left on the outer side, so translucent strokes
+// cover nothing twice. Where a segment is too short to reach that point, the inner corners stay
+// square and overlap. Writes the corners into `end` and `start` and returns the wedge's vertices.
+static int strokePathJoin(Vector2 *out,
+                          Vector2 previous,
+                          Vector2 joint,
+                          Vector2 next,
+                          float halfThickness,
+                          Vector2 *end,
+                          Vector2 *start) {
+  Vector2 before = getPathDirection(previous, joint);
+  Vector2 after = getPathDirection(joint, next);
+  getPathEdge(end, joint, before, halfThickness);
+  getPathEdge(start, joint, after, halfThickness);
+
+  float turn = before.x * after.y - before.y * after.x;
+  if (fabsf(turn) < 1e-4f) return 0;
+
+  int inner = turn > 0 ? 0 : 1;
+  Vector2 miter = Vector2Scale(
+      Vector2Add(Vector2Subtract(end[inner], joint), Vector2Subtract(start[inner], joint)),
+      1.0f / (1.0f + Vector2DotProduct(before, after)));
+  float reach = fabsf(Vector2DotProduct(miter, before)) * 2;
+
+  out[0] = joint;
+  if ((reach <= Vector2Distance(previous, joint)) && (reach <= Vector2Distance(joint, next))) {
+    out[0] = Vector2Add(joint, miter);
+    end[inner] = out[0];
+    start[inner] = out[0];
+  }
 
-    if (!each->done) {
-      each->elapsedTime += dt;
-      each->interpolate(each, fminf(each->elapsedTime / each->duration, 1.0f));
-    } else {
-      completedNum++;
-      continue;
-    }
+  out[1] = end[1 - inner];
+  out[2] = start[1 - inner];
+  orientTriangle(out);
+  return 3;
+}
+
+static bool hasPathJoin(RAPath *path, int idx) {
+  return (idx > 1) && path->points.points[idx].penDown && path->points.points[idx - 1].penDown;
+}
 
-    bool completed = (each->elapsedTime >= each->duration);
-    if (completed) {
-      completedNum++;
-      each->done = true;
+static void buildPathStroke(RAPath *path) {
+  int pointCount = path->points.count;
+  clearPathOffsets(&path->strokeOffsets);
+  reservePathOffsets(&path->strokeOffsets, pointCount);
+  reservePathVertices(&path->strokeVertices, 12 * pointCount);
+
+  float halfThickness = path->thickness / 2;
+  Vector2 *vertices = path->strokeVertices.vertices;
+  int count = 0;
+
+  PathPoint *points = path->points.points;
+  Vector2 wedge[3];
+  Vector2 start[2];
+  Vector2 end[2];
+
+  pushToPathOffsets(&path->strokeOffsets, 0);
+  for (int i = 1; i < pointCount; i++) {
+    if (points[i].penDown) {
+      Vector2 from = points[i - 1].position;
+      Vector2 to = points[i].position;
+      Vector2 direction = getPathDirection(from, to);
+      getPathEdge(start, from, direction, halfThickness);
+      getPathEdge(end, to, direction, halfThickness);
+
+      if (hasPathJoin(path, i))
+        count += strokePathJoin(
+            vertices + count, points[i - 2].position, from, to, halfThickness, wedge, start);
+
+      // The end corners come from the next join, whose wedge is emitted with the next segment.
+      if ((i + 1 < pointCount) && hasPathJoin(path, i + 1)) {
+        Vector2 unused[2];
+        strokePathJoin(wedge, from, to, points[i + 1].position, halfThickness, end, unused);
+      }
+
+      count += strokePathSegment(vertices + count, start, end);
     }
+
+    pushToPathOffsets(&path->strokeOffsets, count);
   }
 
-  return completedNum == anim->animCount;
-}
+  path->strokeVertices.count = count;
 
-void interpolateDefaultSyncAnimation(void *self, float time) {
-  (void)self;
-  (void)time;
+  path->strokeThickness = path->thickness;
 }
 
-void pushToObjectsDefaultSyncAnimation(Scene *scene) {
-  SyncAnimation *anim = (SyncAnimation *)scene->currentAnimation;
+void renderDefaultPath(void *self) {
+  RAPath *path = (RAPath *)self;
+  float target = path->reveal * getPathLength(path);
+  if ((path->points.count < 2) || (target <= 0.0f)) return;
 
-  for (int i = 0; i < anim->animCount; i++) {
-    Animation *eachAnim = anim->animations[i];
-    RAObject *eachObj = eachAnim->object;
-    int idx = findIndexFromRAObjects(&scene->objects, eachObj);
+  if (path->strokeThickness != path->thickness) buildPathStroke(path);
 
-    if (idx == -1) {
-      pushToRAObjects(&scene->objects, eachObj);
+  PathPoint *points = path->points.points;
+  int low = 1;
+  int high = path->points.count - 1;
+  while (low < high) {
+    int mid = (low + high) / 2;
+    if (points[mid].length < target) {
+      low = mid + 1;
     } else {
-      setToRAObjects(&scene->objects, idx, eachObj);
+      high = mid;
     }
+  }
 
-    TraceLog(LOG_INFO, "RayAnim: Started Animation #%i", eachAnim->_id);
+  Color color = resolveRAObjectColor(&path->base, path->base.color);
+  if (color.a == 0) return;
+
+  int prefixCount = path->strokeOffsets.offsets[low - 1];
+  reserveBatch(prefixCount + 12);
+
+  Vector2 *vertices = getBatchVertices();
+  Vector2 offset = path->base.position;
+  int count = 0;
+
+  for (; count < prefixCount; count++)
+    vertices[count] = Vector2Add(path->strokeVertices.vertices[count], offset);
+
+  if (points[low].penDown) {
+    float halfThickness = path->thickness / 2;
+    Vector2 from = points[low - 1].position;
+    Vector2 to = points[low].position;
+    float segmentLength = points[low].length - points[low - 1].length;
+    float fraction = segmentLength > 0 ? (target - points[low - 1].length) / segmentLength : 1.0f;
+    Vector2 cut = Vector2Lerp(from, to, fminf(fraction, 1.0f));
+    Vector2 direction = getPathDirection(from, to);
+    Vector2 start[2];
+    Vector2 end[2];
+    getPathEdge(start, from, direction, halfThickness);
+    getPathEdge(end, cut, direction, halfThickness);
+
+    if (hasPathJoin(path, low)) {
+      Vector2 unused[2];
+      count += strokePathJoin(
+          vertices + count, points[low - 2].position, from, to, halfThickness, unused, start);
+    }
+
+    // A cut short of the shared inner corner would fold the quad back over the join.
+    for (int k = 0; k < 2; k++)
+      if (Vector2DotProduct(Vector2Subtract(end[k], start[k]), direction) < 0) end[k] = start[k];
+
+    if (Vector2Distance(from, cut) > 0) count += strokePathSegment(vertices + count, start, end);
+
+    for (int i = prefixCount; i < count; i++) vertices[i] = Vector2Add(vertices[i], offset);
   }
+
+  Color *colors = getBatchColors();
+  for (int i = 0; i < count; i++) colors[i] = color;
+  commitBatch(count);
 }
 
-// ----------------- Sync ------------------
+RAHash hashDefaultPath(void *self, RAHash hash) {
+  RAPath *path = (RAPath *)self;
 
-// ----------------- Move ------------------
+  hash = hashRAObjectBase(&path->base, hash);
+  hash = hashBytes(hash, &path->geometryHash, sizeof(path->geometryHash));
+  hash = hashBytes(hash, &path->thickness, sizeof(path->thickness));
+  hash = hashBytes(hash, &path->reveal, sizeof(path->reveal));
 
-void initMoveAnimation(MoveAnimation *anim,
-                       Animation *targetAnim,
-                       float duration,
-                       Vector2 targetPos,
-                       bool (*update)(void *, float),
-                       void (*interpolate)(void *, float),
-                       void (*pushToObjects)(Scene *)) {
-  assert((targetAnim != NULL) && (targetAnim->object != NULL));
-  initAnimation((Animation *)anim, NULL, duration, update, interpolate, pushToObjects);
-  anim->targetAnim = targetAnim;
-  anim->initialPosition = targetAnim->object->position;
-  anim->targetPosition = targetPos;
+  return hash;
 }
 
-void initDefaultMoveAnimation(MoveAnimation *anim, Animation *targetAnim, Vector2 targetPos) {
-  initMoveAnimation(anim,
-                    targetAnim,
-                    0.8f,
-                    targetPos,
-                    updateDefaultMoveAnimation,
-                    NULL,
-                    pushToObjectsDefaultMoveAnimation);
+Rectangle boundsDefaultPath(void *self) {
+  RAPath *path = (RAPath *)self;
+  float halfThickness = path->thickness / 2;
+
+  return (Rectangle){path->base.position.x + path->extent.x - halfThickness,
+                     path->base.position.y + path->extent.y - halfThickness,
+                     path->extent.width + path->thickness,
+                     path->extent.height + path->thickness};
 }
 
-MoveAnimation createMoveAnimation(Animation *targetAnim, Vector2 targetPos) {
-  MoveAnimation anim;
-  initDefaultMoveAnimation(&anim, targetAnim, targetPos);
-  return anim;
+void destroyPath(RAPath *path) {
+  destroyPathPoints(&path->points);
+  destroyPathVertices(&path->strokeVertices);
+  destroyPathOffsets(&path->strokeOffsets);
 }
 
-bool updateDefaultMoveAnimation(void *self, float dt) {
-  MoveAnimation *anim = (MoveAnimation *)self;
-  Animation *targetAnim = anim->targetAnim;
+void initPathAnimation(Animation *anim,
+                       RAPath *path,
+                       float duration,
+                       bool (*update)(void *, double),
+                       void (*interpolate)(void *, float)) {
+  initAnimation(
+      anim, (RAObject *)path, duration, update, interpolate, pushToObjectsDefaultAnimation);
+}
 
-  if (anim->base.done && targetAnim->done) return true;
+void initDefaultPathAnimation(Animation *anim, RAPath *path) {
+  initPathAnimation(anim, path, 1.5f, updateDefaultAnimation, interpolateDefaultPathAnimation);
+}
 
-  float t = fminf(anim->base.elapsedTime / anim->base.duration, 1.0f);
-  float dx = (anim->targetPosition.x - anim->initialPosition.x) * t;
-  float dy = (anim->targetPosition.y - anim->initialPosition.y) * t;
+Animation createPathAnimation(RAPath *path) {
+  Animation anim;
+  initDefaultPathAnimation(&anim, path);
+  return anim;
+}
 
-  anim->targetAnim->object->position.x = anim->initialPosition.x + dx;
-  anim->targetAnim->object->position.y = anim->initialPosition.y + dy;
+void interpolateDefaultPathAnimation(void *self, float time) {
+  Animation *anim = (Animation *)self;
+  RAPath *path = (RAPath *)anim->object;
+  path->reveal = time;
+}
 
-  bool innerAnimCompleted = targetAnim->update(targetAnim, dt);
+// ---------------- RAPath ----------------
+
+// ---------------- RAMorph ---------------
+
+void initMorph(
+    RAMorph *morph, RAObject *from, RAObject *to, int pointCount, void (*render)(void *)) {
+  assert((from != NULL) && (to != NULL) && (pointCount >= 3));
+
+  initRAObject(&morph->base, (Vector2){0.0f, 0.0f}, from->color, render);
+  morph->base.hash = hashDefaultMorph;
+  morph->base.bounds = boundsDefaultMorph;
+
+  morph->from = from;
+  morph->to = to;
+  morph->pointCount = pointCount;
+  morph->prepared = false;
+  morph->progress = 0.0f;
+  morph->fromSegments = 0;
+  morph->toSegments = 0;
+  morph->outlineSegments = 0;
+
+  // One block holds all six point arrays.
+  float *points = allocateMemory(MEMORY_OBJECTS, 6 * pointCount * sizeof(float));
+  assert(points != NULL);
+  morph->fromX = points;
+  morph->fromY = points + pointCount;
+  morph->deltaX = points + 2 * pointCount;
+  morph->deltaY = points + 3 * pointCount;
+  morph->x = points + 4 * pointCount;
+  morph->y = points + 5 * pointCount;
+}
 
-  anim->base.elapsedTime += dt;
+void initDefaultMorph(RAMorph *morph, RAObject *from, RAObject *to) {
+  initMorph(morph, from, to, MORPH_POINT_COUNT, renderDefaultMorph);
+}
 
-  bool selfCompleted = anim->base.elapsedTime >= anim->base.duration;
-  if (selfCompleted) anim->base.done = true;
+RAMorph createMorph(RAObject *from, RAObject *to) {
+  RAMorph morph;
+  initDefaultMorph(&morph, from, to);
+  return morph;
+}
 
-  return innerAnimCompleted && selfCompleted;
+static bool isCircleRenderer(void (*render)(void *)) {
+  return (render == renderDefaultCircle) || (render == renderFillInnerCircle);
 }
 
-void pushToObjectsDefaultMoveAnimation(Scene *scene) {
-  MoveAnimation *anim = (MoveAnimation *)scene->currentAnimation;
-  RAObject *currentObj = anim->targetAnim->object;
-  TraceLog(LOG_INFO, "RayAnim: Started Animation #%i", anim->base._id);
-  pushToRAObjects(&scene->objects, currentObj);
+static bool isRectangleRenderer(void (*render)(void *)) {
+  return (render == renderDefaultRectangle) || (render == renderFillInnerRectangle);
 }
 
-// ----------------- Move ------------------
+// Samples a polyline at roughly equal arc lengths, placing a point on every vertex so that
+// corners are kept. A closed polyline repeats its first vertex at the end, which is not sampled
+// again. Returns the length of the polyline.
+static float samplePolyline(
+    const Vector2 *vertices, int vertexCount, bool closed, int pointCount, float *x, float *y) {
+  float lengths[vertexCount];
+  lengths[0] = 0.0f;
+  for (int k = 1; k < vertexCount; k++)
+    lengths[k] = lengths[k - 1] + Vector2Distance(vertices[k - 1], vertices[k]);
+
+  float total = lengths[vertexCount - 1];
+  int last = closed ? pointCount : pointCount - 1;
+  int start = 0;
+
+  for (int k = 0; k + 1 < vertexCount; k++) {
+    int end = total > 0.0f ? (int)(lengths[k + 1] / total * last + 0.5f) : last;
+
+    for (int i = start; i < end; i++) {
+      Vector2 point = Vector2Lerp(vertices[k], vertices[k + 1], (float)(i - start) / (end - start));
+      x[i] = point.x;
+      y[i] = point.y;
+    }
+    start = end > start ? end : start;
+  }
 
-// ---------------- RAText ----------------
+  for (int i = start; i < pointCount; i++) {
+    x[i] = vertices[vertexCount - 1].x;
+    y[i] = vertices[vertexCount - 1].y;
+  }
 
-void initText(RAText *text,
-              char *fullText,
-              FontIndex fontIdx,
-              Color tint,
-              float charRevealTime,
-              float fontSize,
-              float spacing,
-              Vector2 pos,
-              void (*render)(void *)) {
-  initRAObject(&text->base, pos, tint, render);
-  text->spacing = spacing;
-  text->fontSize = fontSize;
-  text->fullText = fullText;
-  text->displayCharCount = 0;
-  text->charRevealTime = charRevealTime;
-  text->fontIdx = fontIdx;
+  return total;
 }
 
-void initDefaultText(RAText *text, char *fullText, Vector2 pos) {
-  initText(text, fullText, 0, BLACK, 0.03f, 100, 12.5f, pos, renderDefaultText);
+// Samples the centre line of the part of the shape's outline that is drawn, clockwise on screen,
+// starting at the rightmost point of a circle or the top-left corner of a rectangle. segments is
+// set to the number of edges from point 0 that the outline strokes; a partly drawn outline is
+// closed for the fill only, through the centre of a filled circle's sector. Rectangle sides are
+// assumed to be drawn in order, as their animation does.
+bool sampleShapeOutline(RAObject *obj, int pointCount, float *x, float *y, int *segments) {
+  if (isCircleRenderer(obj->render)) {
+    RACircle *circle = (RACircle *)obj;
+    float sweep = fminf(fmaxf(circle->angle, 0.0f), 360.0f) * DEG2RAD;
+    bool closed = sweep >= 2.0f * PI;
+    bool sector = !closed && (obj->render == renderFillInnerCircle);
+    int arcCount = sector ? pointCount - 1 : pointCount;
+
+    for (int i = 0; i < arcCount; i++) {
+      float angle = closed ? sweep * i / arcCount : sweep * i / (arcCount - 1);
+      x[i] = obj->position.x + cosf(angle) * circle->radius;
+      y[i] = obj->position.y + sinf(angle) * circle->radius;
+    }
+
+    if (sector) {
+      x[pointCount - 1] = obj->position.x;
+      y[pointCount - 1] = obj->position.y;
+    }
+
+    *segments = closed ? pointCount : (sweep > 0.0f ? arcCount - 1 : 0);
+    return true;
+  }
+
+  if (isRectangleRenderer(obj->render)) {
+    RARectangle *rect = (RARectangle *)obj;
+    float inset = rect->outlineThickness / 2;
+    float left = obj->position.x + inset;
+    float top = obj->position.y + inset;
+    float right = left + fmaxf(rect->width - rect->outlineThickness, 0.0f);
+    float bottom = top + fmaxf(rect->height - rect->outlineThickness, 0.0f);
+
+    Vector2 corners[5] = {{left, top}, {right, top}, {right, bottom}, {left, bottom}, {left, top}};
+    float quarters[4] = {
+        rect->firstQuarter, rect->secondQuarter, rect->thirdQuarter, rect->lastQuarter};
+    Vector2 vertices[5] = {corners[0]};
+    int vertexCount = 1;
+    bool closed = true;
+
+    for (int k = 0; (k < 4) && closed; k++) {
+      float drawn = fminf(fmaxf(quarters[k], 0.0f), 1.0f);
+      if (drawn > 0.0f) vertices[vertexCount++] = Vector2Lerp(corners[k], corners[k + 1], drawn);
+      closed = drawn >= 1.0f;
+    }
+
+    float length = samplePolyline(vertices, vertexCount, closed, pointCount, x, y);
+    *segments = closed ? pointCount : (length > 0.0f ? pointCount - 1 : 0);
+    return true;
+  }
+
+  return false;
 }
 
-RAText createText(char *fullText, Vector2 pos) {
-  RAText text;
-  initDefaultText(&text, fullText, pos);
-  return text;
+static void getShapeStyle(RAObject *obj, float *thickness, Color *outline, Color *fill) {
+  bool filled = (obj->render == renderFillInnerCircle) || (obj->render == renderFillInnerRectangle);
+
+  if (isCircleRenderer(obj->render)) {
+    *thickness = ((RACircle *)obj)->outlineThickness;
+    *outline = ((RACircle *)obj)->outlineColor;
+  } else {
+    *thickness = ((RARectangle *)obj)->outlineThickness;
+    *outline = ((RARectangle *)obj)->outlineColor;
+  }
+
+  *fill = obj->color;
+  if (!filled) fill->a = 0;
 }
 
-void renderDefaultText(void *self) {
-  RAText *text = (RAText *)self;
+// Returns the cyclic shift of the end outline that best matches the start outline, comparing
+// both relative to their centroids so that the match does not depend on where the shapes are.
+static int findMorphShift(RAMorph *morph, const float *toX, const float *toY) {
+  int count = morph->pointCount;
+  float fromCenterX = 0.0f;
+  float fromCenterY = 0.0f;
+  float toCenterX = 0.0f;
+  float toCenterY = 0.0f;
+
+  for (int i = 0; i < count; i++) {
+    fromCenterX += morph->fromX[i] / count;
+    fromCenterY += morph->fromY[i] / count;
+    toCenterX += toX[i] / count;
+    toCenterY += toY[i] / count;
+  }
 
-  Font font = fonts[text->fontIdx];
-  Color tint = text->base.color;
-  char displayText[text->displayCharCount];
+  int bestShift = 0;
+  float bestCost = FLT_MAX;
 
-  strncpy(displayText, text->fullText, text->displayCharCount - 1);
-  displayText[text->displayCharCount - 1] = '\0';
+  for (int shift = 0; shift < count; shift++) {
+    float cost = 0.0f;
 
-  DrawTextEx(font, displayText, text->base.position, text->fontSize, text->spacing, tint);
-}
+    for (int i = 0; i < count; i++) {
+      int j = (i + shift) % count;
+      float dx = (toX[j] - toCenterX) - (morph->fromX[i] - fromCenterX);
+      float dy = (toY[j] - toCenterY) - (morph->fromY[i] - fromCenterY);
+      cost += dx * dx + dy * dy;
+    }
 
-void setFontForText(RAText *text, char *filename) {
-  fonts[fontCount++] = LoadFont(filename);
-  text->fontIdx = fontCount - 1;
+    if (cost < bestCost) {
+      bestCost = cost;
+      bestShift = shift;
+    }
+  }
+
+  return bestShift;
 }
 
-void setFontForTextEx(
-    RAText *text, char *filename, int fontSize, int *codepoints, int codepointCount) {
-  fonts[fontCount++] = LoadFontEx(filename, fontSize, codepoints, codepointCount);
-  text->fontIdx = fontCount - 1;
+// Samples and matches both outlines. Called by the animation when it starts, as the shapes may
+// have been moved or resized since the morph was created. Open outlines both start at their
+// first drawn point, so they are matched as they are.
+void prepareMorph(RAMorph *morph) {
+  int count = morph->pointCount;
+  float toX[count];
+  float toY[count];
+
+  bool sampled =
+      sampleShapeOutline(morph->from, count, morph->fromX, morph->fromY, &morph->fromSegments) &&
+      sampleShapeOutline(morph->to, count, toX, toY, &morph->toSegments);
+  assert(sampled && "RAMorph supports circles and rectangles");
+  (void)sampled;
+
+  bool closed = (morph->fromSegments == count) && (morph->toSegments == count);
+  int shift = closed ? findMorphShift(morph, toX, toY) : 0;
+  for (int i = 0; i < count; i++) {
+    int j = (i + shift) % count;
+    morph->deltaX[i] = toX[j] - morph->fromX[i];
+    morph->deltaY[i] = toY[j] - morph->fromY[i];
+  }
+
+  Color *fromFill = &morph->fromFillColor;
+  Color *toFill = &morph->toFillColor;
+  getShapeStyle(morph->from, &morph->fromThickness, &morph->fromOutlineColor, fromFill);
+  getShapeStyle(morph->to, &morph->toThickness, &morph->toOutlineColor, toFill);
+
+  // A missing fill fades in or out instead of passing through black.
+  if (fromFill->a == 0) *fromFill = (Color){toFill->r, toFill->g, toFill->b, 0};
+  if (toFill->a == 0) *toFill = (Color){fromFill->r, fromFill->g, fromFill->b, 0};
+
+  morph->prepared = true;
+  setMorphProgress(morph, morph->progress);
 }
 
-void initTextAnimation(Animation *anim,
-                       RAText *text,
-                       float duration,
-                       bool (*update)(void *, float),
-                       void (*interpolate)(void *, float)) {
-  initAnimation(
-      anim, (RAObject *)text, duration, update, interpolate, pushToObjectsDefaultAnimation);
+static Color lerpColor(Color a, Color b, float t) {
+  return (Color){(unsigned char)(a.r + (b.r - a.r) * t + 0.5f),
+                 (unsigned char)(a.g + (b.g - a.g) * t + 0.5f),
+                 (unsigned char)(a.b + (b.b - a.b) * t + 0.5f),
+                 (unsigned char)(a.a + (b.a - a.a) * t + 0.5f)};
 }
 
-void initDefaultTextAnimation(Animation *anim, RAText *text) {
-  initTextAnimation(anim,
-                    text,
-                    text->charRevealTime * strlen(text->fullText),
-                    updateDefaultAnimation,
-                    interpolateDefaultTextAnimation);
+void setMorphProgress(RAMorph *morph, float progress) {
+  morph->progress = progress;
+  if (!morph->prepared) return;
+
+  int count = morph->pointCount;
+  const float *restrict fromX = morph->fromX;
+  const float *restrict fromY = morph->fromY;
+  const float *restrict deltaX = morph->deltaX;
+  const float *restrict deltaY = morph->deltaY;
+  float *restrict x = morph->x;
+  float *restrict y = morph->y;
+
+  for (int i = 0; i < count; i++) x[i] = fromX[i] + deltaX[i] * progress;
+  for (int i = 0; i < count; i++) y[i] = fromY[i] + deltaY[i] * progress;
+
+  morph->thickness = morph->fromThickness + (morph->toThickness - morph->fromThickness) * progress;
+  morph->outlineSegments =
+      (int)(morph->fromSegments + (morph->toSegments - morph->fromSegments) * progress + 0.5f);
+  morph->outlineColor = lerpColor(morph->fromOutlineColor, morph->toOutlineColor, progress);
+  morph->base.color = lerpColor(morph->fromFillColor, morph->toFillColor, progress);
+  markRAObjectDirty(&morph->base);
 }
 
-Animation createTextAnimation(RAText *text) {
-  Animation anim;
-  initDefaultTextAnimation(&anim, text);
-  return anim;
+static Vector2 getMorphEdgeNormal(RAMorph *morph, int from, int to) {
+  Vector2 edge = {morph->x[to] - morph->x[from], morph->y[to] - morph->y[from]};
+  float length = sqrtf(edge.x * edge.x + edge.y * edge.y);
+  if (length <= 0.0f) return (Vector2){0.0f, 0.0f};
+
+  return (Vector2){-edge.y / length, edge.x / length};
 }
 
-void interpolateDefaultTextAnimation(void *self, float time) {
-  (void)time;
-  Animation *anim = (Animation *)self;
-  RAText *text = (RAText *)anim->object;
+// The stroke corners at point i. Where two edges meet they are offset along the miter, so that
+// both edges keep their full width and rectangle corners stay square; sharper joins are capped
+// at MORPH_MITER_LIMIT. The ends of an open outline are offset along their only edge.
+static void getMorphEdge(RAMorph *morph, int i, float half, Vector2 offset, Vector2 edge[2]) {
+  int count = morph->pointCount;
+  bool closed = morph->outlineSegments == count;
+  Vector2 previous = {0.0f, 0.0f};
+  Vector2 next = {0.0f, 0.0f};
+  if (closed || (i > 0)) previous = getMorphEdgeNormal(morph, (i + count - 1) % count, i);
+  if (closed || (i < morph->outlineSegments)) next = getMorphEdgeNormal(morph, i, (i + 1) % count);
+
+  Vector2 miter = Vector2Add(previous, next);
+  float length = sqrtf(miter.x * miter.x + miter.y * miter.y);
+  if (length > 0.0f) {
+    miter = Vector2Scale(miter, 1.0f / length);
+    float cosine = fmaxf(Vector2DotProduct(miter, previous), Vector2DotProduct(miter, next));
+    miter = Vector2Scale(miter, 1.0f / fmaxf(cosine, 1.0f / MORPH_MITER_LIMIT));
+  }
 
-  if ((anim->elapsedTime >= (text->charRevealTime * text->displayCharCount)) &&
-      (text->displayCharCount <= strlen(text->fullText)))
-    text->displayCharCount++;
+  Vector2 point = {offset.x + morph->x[i], offset.y + morph->y[i]};
+  edge[0] = Vector2Subtract(point, Vector2Scale(miter, half));
+  edge[1] = Vector2Add(point, Vector2Scale(miter, half));
 }
 
-// ---------------- RAText ----------------
+void renderDefaultMorph(void *self) {
+  RAMorph *morph = (RAMorph *)self;
+  if (!morph->prepared) return;
+
+  int count = morph->pointCount;
+  Vector2 offset = morph->base.position;
+  Color fill = resolveRAObjectColor(&morph->base, morph->base.color);
+  Color outline = resolveRAObjectColor(&morph->base, morph->outlineColor);
+  float half = morph->thickness / 2;
+
+  if (fill.a > 0) {
+    Vector2 center = offset;
+    for (int i = 0; i < count; i++) {
+      center.x += morph->x[i] / count;
+      center.y += morph->y[i] / count;
+    }
 
-// --------------- RAImage ----------------
+    for (int i = 0; i < count; i++) {
+      int next = (i + 1) % count;
+      batchTriangle(center,
+                    (Vector2){offset.x + morph->x[i], offset.y + morph->y[i]},
+                    (Vector2){offset.x + morph->x[next], offset.y + morph->y[next]},
+                    fill);
+    }
+  }
 
-void initImage(
-    RAImage *image, char *filename, Vector2 pos, float scale, Color tint, void (*render)(void *)) {
-  initRAObject(&image->base, pos, tint, render);
-  image->filename = filename;
-  image->scale = scale;
+  if ((outline.a == 0) || (half <= 0.0f) || (morph->outlineSegments == 0)) return;
 
-  textures[textureCount++] = LoadTexture(filename);
-  image->textureIdx = textureCount - 1;
-}
+  Vector2 start[2];
+  getMorphEdge(morph, 0, half, offset, start);
 
-void initDefaultImage(RAImage *image, char *filename, Vector2 pos) {
-  initImage(image, filename, pos, 1.0f, RAYWHITE, renderDefaultImage);
+  for (int i = 1; i <= morph->outlineSegments; i++) {
+    Vector2 end[2];
+    getMorphEdge(morph, i % count, half, offset, end);
+
+    batchTriangle(start[0], start[1], end[1], outline);
+    batchTriangle(start[0], end[1], end[0], outline);
+    start[0] = end[0];
+    start[1] = end[1];
+  }
 }
 
-RAImage createImage(char *filename, Vector2 pos) {
-  RAImage image;
-  initDefaultImage(&image, filename, pos);
-  return image;
+RAHash hashDefaultMorph(void *self, RAHash hash) {
+  RAMorph *morph = (RAMorph *)self;
+
+  hash = hashRAObjectBase(&morph->base, hash);
+  hash = hashBytes(hash, &morph->prepared, sizeof(morph->prepared));
+  if (!morph->prepared) return hash;
+
+  hash = hashBytes(hash, morph->x, morph->pointCount * sizeof(float));
+  hash = hashBytes(hash, morph->y, morph->pointCount * sizeof(float));
+  hash = hashBytes(hash, &morph->thickness, sizeof(morph->thickness));
+  hash = hashBytes(hash, &morph->outlineColor, sizeof(morph->outlineColor));
+  hash = hashBytes(hash, &morph->outlineSegments, sizeof(morph->outlineSegments));
+
+  return hash;
 }
 
-void renderDefaultImage(void *self) {
-  RAImage *image = (RAImage *)self;
-  Texture texture = textures[image->textureIdx];
-  Color tint = image->base.color;
+Rectangle boundsDefaultMorph(void *self) {
+  RAMorph *morph = (RAMorph *)self;
+  if (!morph->prepared) return morph->from->bounds(morph->from);
+
+  float minX = FLT_MAX;
+  float minY = FLT_MAX;
+  float maxX = -FLT_MAX;
+  float maxY = -FLT_MAX;
+
+  for (int i = 0; i < morph->pointCount; i++) {
+    minX = fminf(minX, morph->x[i]);
+    minY = fminf(minY, morph->y[i]);
+    maxX = fmaxf(maxX, morph->x[i]);
+    maxY = fmaxf(maxY, morph->y[i]);
+  }
 
-  DrawTextureEx(texture, image->base.position, 0.0f, image->scale, tint);
+  // Miter joins reach out to MORPH_MITER_LIMIT times the half thickness.
+  float reach = morph->thickness / 2 * MORPH_MITER_LIMIT;
+  return (Rectangle){morph->base.position.x + minX - reach,
+                     morph->base.position.y + minY - reach,
+                     maxX - minX + 2 * reach,
+                     maxY - minY + 2 * reach};
 }
 
-void initImageAnimation(Animation *anim,
-                        RAImage *image,
+void destroyMorph(RAMorph *morph) {
+  releaseMemory(morph->fromX);
+  morph->fromX = NULL;
+  morph->prepared = false;
+}
+
+void initMorphAnimation(Animation *anim,
+                        RAMorph *morph,
                         float duration,
-                        bool (*update)(void *, float),
+                        bool (*update)(void *, double),
                         void (*interpolate)(void *, float)) {
   initAnimation(
-      anim, (RAObject *)image, duration, update, interpolate, pushToObjectsDefaultAnimation);
+      anim, (RAObject *)morph, duration, update, interpolate, pushToObjectsDefaultAnimation);
+  anim->reset = resetDefaultMorphAnimation;
 }
 
-void initDefaultImageAnimation(Animation *anim, RAImage *image) {
-  initImageAnimation(anim, image, 0.8f, updateDefaultAnimation, interpolateDefaultImageAnimation);
+void initDefaultMorphAnimation(Animation *anim, RAMorph *morph) {
+  initMorphAnimation(anim, morph, 1.0f, updateDefaultAnimation, interpolateDefaultMorphAnimation);
 }
 
-Animation createImageAnimation(RAImage *image) {
+Animation createMorphAnimation(RAMorph *morph) {
   Animation anim;
-  initDefaultImageAnimation(&anim, image);
+  initDefaultMorphAnimation(&anim, morph);
   return anim;
 }
 
-void interpolateDefaultImageAnimation(void *self, float time) {
+void interpolateDefaultMorphAnimation(void *self, float time) {
   Animation *anim = (Animation *)self;
-  RAImage *image = (RAImage *)anim->object;
-  image->base.color.a = (unsigned char)(255 * time);
+  RAMorph *morph = (RAMorph *)anim->object;
+
+  if (!morph->prepared) prepareMorph(morph);
+  setMorphProgress(morph, time);
 }
 
-// --------------- RAImage ----------------
+// Runs when the animation starts, before any updates, so reading the shapes and hiding the
+// start shape cannot race with animations that update in parallel.
+void resetDefaultMorphAnimation(void *self) {
+  RAMorph *morph = (RAMorph *)((Animation *)self)->object;
+
+  prepareMorph(morph);
+  morph->from->opacity = 0.0f;
+  markRAObjectDirty(morph->from);
+}
+
+// ---------------- RAMorph ---------------
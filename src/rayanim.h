@@ -1,110 +1,1039 @@
 #ifndef RAYANIM_H
 #define RAYANIM_H
 
+#include <pthread.h>
 #include <raylib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 #define DA_INIT_SIZE 12
+#define MAX_MIP_LEVELS 16
+#define MAX_LOADED_ASSETS 255
+#define SPATIAL_CELL_SIZE 128.0f
+#define SYNC_PARALLEL_THRESHOLD 64
+#define SYNC_PARALLEL_CHUNK 16
+#define EXPORT_PIPELINE_DEPTH 4
+#define FRAME_RING_MAGIC 0x52465241u
+#define FRAME_RING_VERSION 1
+#define FRAME_RING_ALIGN 64
+#define FRAME_RING_BLOCK_TIMEOUT 5.0
+#define SPATIAL_CELL_INLINE 4
+#define SDF_FONT_SIZE 48
+#define MAX_RENDITIONS 8
+#define RENDER_SERVER_MAX_JOBS 4
+#define RENDER_SERVER_MEMORY_BUDGET ((size_t)1 << 30)
+#define RENDER_SERVER_REQUEST_SIZE 1024
+#define MORPH_POINT_COUNT 128
+#define MORPH_MITER_LIMIT 2.0f
+#define FRAME_SEQUENCE_MAGIC 0x53464152u
+#define FRAME_SEQUENCE_VERSION 1
+#define FRAME_SEQUENCE_TILE_SIZE 64
+#define FRAME_SEQUENCE_KEYFRAME_INTERVAL 60
+#define FRAME_SEQUENCE_MAX_SIZE 16384
+#define FRAME_CACHE_VERSION 2
+#define PROXY_IMAGE_MAGIC 0x58525052u
+#define PROXY_MIN_SEGMENTS 12
+
+// Typed containers. DECLARE_* goes where the type is needed and DEFINE_* in one translation
+// unit that includes assert.h and string.h, naming the MemoryCategory its storage is counted
+// under. A zeroed container is empty and valid.
+// Vectors grow geometrically, deques are power-of-two rings with O(1) push and pop at both
+// ends, and small vectors keep their first inlineCount items inside the struct.
+
+#define DECLARE_VECTOR(Name, Type, field)             \
+  typedef struct Name {                               \
+    Type *field;                                      \
+    int count;                                        \
+    int capacity;                                     \
+  } Name;                                             \
+  void init##Name(Name *vector);                      \
+  void reserve##Name(Name *vector, int capacity);     \
+  void shrink##Name(Name *vector);                    \
+  void clear##Name(Name *vector);                     \
+  void pushTo##Name(Name *vector, Type item);         \
+  Type popFrom##Name(Name *vector);                   \
+  Type getFrom##Name(Name *vector, int idx);          \
+  void setTo##Name(Name *vector, int idx, Type item); \
+  void destroy##Name(Name *vector);
+
+#define DECLARE_DEQUE(Name, Type)                    \
+  typedef struct Name {                              \
+    Type *items;                                     \
+    int head;                                        \
+    int count;                                       \
+    int capacity;                                    \
+  } Name;                                            \
+  void init##Name(Name *deque);                      \
+  void reserve##Name(Name *deque, int capacity);     \
+  void shrink##Name(Name *deque);                    \
+  void clear##Name(Name *deque);                     \
+  void pushTo##Name(Name *deque, Type item);         \
+  void pushFirstTo##Name(Name *deque, Type item);    \
+  Type popFrom##Name(Name *deque);                   \
+  Type popFirstFrom##Name(Name *deque);              \
+  Type getFrom##Name(Name *deque, int idx);          \
+  void setTo##Name(Name *deque, int idx, Type item); \
+  void destroy##Name(Name *deque);
+
+#define DECLARE_SMALL_VECTOR(Name, Type, inlineCount) \
+  typedef struct Name {                               \
+    Type inlineItems[inlineCount];                    \
+    Type *heapItems;                                  \
+    int count;                                        \
+    int capacity;                                     \
+  } Name;                                             \
+  void init##Name(Name *vector);                      \
+  Type *get##Name##Items(Name *vector);               \
+  void reserve##Name(Name *vector, int capacity);     \
+  void shrink##Name(Name *vector);                    \
+  void clear##Name(Name *vector);                     \
+  void pushTo##Name(Name *vector, Type item);         \
+  Type popFrom##Name(Name *vector);                   \
+  Type getFrom##Name(Name *vector, int idx);          \
+  void setTo##Name(Name *vector, int idx, Type item); \
+  void swapRemoveFrom##Name(Name *vector, int idx);   \
+  void destroy##Name(Name *vector);
+
+#define DEFINE_VECTOR(Name, Type, field, category)                                          \
+  void init##Name(Name *vector) {                                                           \
+    *vector = (Name){NULL, 0, 0};                                                           \
+  }                                                                                         \
+                                                                                            \
+  void reserve##Name(Name *vector, int capacity) {                                          \
+    if (capacity <= vector->capacity) return;                                               \
+                                                                                            \
+    Type *items = reallocateMemory(category, vector->field, capacity * sizeof(Type));       \
+    assert(items != NULL);                                                                  \
+                                                                                            \
+    vector->field = items;                                                                  \
+    vector->capacity = capacity;                                                            \
+  }                                                                                         \
+                                                                                            \
+  void shrink##Name(Name *vector) {                                                         \
+    if (vector->count == 0) {                                                               \
+      destroy##Name(vector);                                                                \
+      return;                                                                               \
+    }                                                                                       \
+                                                                                            \
+    size_t size = vector->count * sizeof(Type);                                             \
+    Type *items = reallocateMemory(category, vector->field, size);                          \
+    if (items == NULL) return;                                                              \
+                                                                                            \
+    vector->field = items;                                                                  \
+    vector->capacity = vector->count;                                                       \
+  }                                                                                         \
+                                                                                            \
+  void clear##Name(Name *vector) {                                                          \
+    vector->count = 0;                                                                      \
+  }                                                                                         \
+                                                                                            \
+  void pushTo##Name(Name *vector, Type item) {                                              \
+    if (vector->count == vector->capacity) {                                                \
+      int capacity = vector->capacity < DA_INIT_SIZE ? DA_INIT_SIZE : vector->capacity * 2; \
+      reserve##Name(vector, capacity);                                                      \
+    }                                                                                       \
+                                                                                            \
+    vector->field[vector->count++] = item;                                                  \
+  }                                                                                         \
+                                                                                            \
+  Type popFrom##Name(Name *vector) {                                                        \
+    if (vector->count == 0) return (Type){0};                                               \
+                                                                                            \
+    return vector->field[--vector->count];                                                  \
+  }                                                                                         \
+                                                                                            \
+  Type getFrom##Name(Name *vector, int idx) {                                               \
+    if ((idx < 0) || (vector->count <= idx)) return (Type){0};                              \
+                                                                                            \
+    return vector->field[idx];                                                              \
+  }                                                                                         \
+                                                                                            \
+  void setTo##Name(Name *vector, int idx, Type item) {                                      \
+    if ((idx < 0) || (vector->count <= idx)) return;                                        \
+                                                                                            \
+    vector->field[idx] = item;                                                              \
+  }                                                                                         \
+                                                                                            \
+  void destroy##Name(Name *vector) {                                                        \
+    releaseMemory(vector->field);                                                           \
+    init##Name(vector);                                                                     \
+  }
+
+#define DEFINE_DEQUE(Name, Type, category)                                          \
+  void init##Name(Name *deque) {                                                    \
+    *deque = (Name){NULL, 0, 0, 0};                                                 \
+  }                                                                                 \
+                                                                                    \
+  static void resize##Name(Name *deque, int capacity) {                             \
+    Type *items = NULL;                                                             \
+    if (capacity > 0) {                                                             \
+      items = allocateMemory(category, capacity * sizeof(Type));                    \
+      assert(items != NULL);                                                        \
+    }                                                                               \
+                                                                                    \
+    for (int i = 0; i < deque->count; i++)                                          \
+      items[i] = deque->items[(deque->head + i) & (deque->capacity - 1)];           \
+                                                                                    \
+    releaseMemory(deque->items);                                                    \
+    deque->items = items;                                                           \
+    deque->head = 0;                                                                \
+    deque->capacity = capacity;                                                     \
+  }                                                                                 \
+                                                                                    \
+  void reserve##Name(Name *deque, int capacity) {                                   \
+    if (capacity <= deque->capacity) return;                                        \
+                                                                                    \
+    int powerOfTwo = 16;                                                            \
+    while (powerOfTwo < capacity) powerOfTwo *= 2;                                  \
+                                                                                    \
+    resize##Name(deque, powerOfTwo);                                                \
+  }                                                                                 \
+                                                                                    \
+  void shrink##Name(Name *deque) {                                                  \
+    int powerOfTwo = deque->count > 0 ? 1 : 0;                                      \
+    while (powerOfTwo < deque->count) powerOfTwo *= 2;                              \
+                                                                                    \
+    if (powerOfTwo < deque->capacity) resize##Name(deque, powerOfTwo);              \
+  }                                                                                 \
+                                                                                    \
+  void clear##Name(Name *deque) {                                                   \
+    deque->head = 0;                                                                \
+    deque->count = 0;                                                               \
+  }                                                                                 \
+                                                                                    \
+  void pushTo##Name(Name *deque, Type item) {                                       \
+    if (deque->count == deque->capacity) reserve##Name(deque, deque->capacity + 1); \
+                                                                                    \
+    deque->items[(deque->head + deque->count) & (deque->capacity - 1)] = item;      \
+    deque->count++;                                                                 \
+  }                                                                                 \
+                                                                                    \
+  void pushFirstTo##Name(Name *deque, Type item) {                                  \
+    if (deque->count == deque->capacity) reserve##Name(deque, deque->capacity + 1); \
+                                                                                    \
+    deque->head = (deque->head - 1) & (deque->capacity - 1);                        \
+    deque->items[deque->head] = item;                                               \
+    deque->count++;                                                                 \
+  }                                                                                 \
+                                                                                    \
+  Type popFrom##Name(Name *deque) {                                                 \
+    if (deque->count == 0) return (Type){0};                                        \
+                                                                                    \
+    deque->count--;                                                                 \
+    return deque->items[(deque->head + deque->count) & (deque->capacity - 1)];      \
+  }                                                                                 \
+                                                                                    \
+  Type popFirstFrom##Name(Name *deque) {                                            \
+    if (deque->count == 0) return (Type){0};                                        \
+                                                                                    \
+    Type item = deque->items[deque->head];                                          \
+    deque->head = (deque->head + 1) & (deque->capacity - 1);                        \
+    deque->count--;                                                                 \
+                                                                                    \
+    return item;                                                                    \
+  }                                                                                 \
+                                                                                    \
+  Type getFrom##Name(Name *deque, int idx) {                                        \
+    if ((idx < 0) || (deque->count <= idx)) return (Type){0};                       \
+                                                                                    \
+    return deque->items[(deque->head + idx) & (deque->capacity - 1)];               \
+  }                                                                                 \
+                                                                                    \
+  void setTo##Name(Name *deque, int idx, Type item) {                               \
+    if ((idx < 0) || (deque->count <= idx)) return;                                 \
+                                                                                    \
+    deque->items[(deque->head + idx) & (deque->capacity - 1)] = item;               \
+  }                                                                                 \
+                                                                                    \
+  void destroy##Name(Name *deque) {                                                 \
+    releaseMemory(deque->items);                                                    \
+    init##Name(deque);                                                              \
+  }
+
+#define DEFINE_SMALL_VECTOR(Name, Type, inlineCount, category)                      \
+  void init##Name(Name *vector) {                                                   \
+    vector->heapItems = NULL;                                                       \
+    vector->count = 0;                                                              \
+    vector->capacity = 0;                                                           \
+  }                                                                                 \
+                                                                                    \
+  Type *get##Name##Items(Name *vector) {                                            \
+    return vector->heapItems != NULL ? vector->heapItems : vector->inlineItems;     \
+  }                                                                                 \
+                                                                                    \
+  void reserve##Name(Name *vector, int capacity) {                                  \
+    if ((capacity <= inlineCount) || (capacity <= vector->capacity)) return;        \
+                                                                                    \
+    size_t size = capacity * sizeof(Type);                                          \
+    Type *items = reallocateMemory(category, vector->heapItems, size);              \
+    assert(items != NULL);                                                          \
+                                                                                    \
+    if (vector->heapItems == NULL)                                                  \
+      memcpy(items, vector->inlineItems, vector->count * sizeof(Type));             \
+                                                                                    \
+    vector->heapItems = items;                                                      \
+    vector->capacity = capacity;                                                    \
+  }                                                                                 \
+                                                                                    \
+  void shrink##Name(Name *vector) {                                                 \
+    if ((vector->heapItems == NULL) || (vector->count == vector->capacity)) return; \
+                                                                                    \
+    if (vector->count <= inlineCount) {                                             \
+      memcpy(vector->inlineItems, vector->heapItems, vector->count * sizeof(Type)); \
+      releaseMemory(vector->heapItems);                                             \
+      vector->heapItems = NULL;                                                     \
+      vector->capacity = 0;                                                         \
+      return;                                                                       \
+    }                                                                               \
+                                                                                    \
+    size_t size = vector->count * sizeof(Type);                                     \
+    Type *items = reallocateMemory(category, vector->heapItems, size);              \
+    if (items == NULL) return;                                                      \
+                                                                                    \
+    vector->heapItems = items;                                                      \
+    vector->capacity = vector->count;                                               \
+  }                                                                                 \
+                                                                                    \
+  void clear##Name(Name *vector) {                                                  \
+    vector->count = 0;                                                              \
+  }                                                                                 \
+                                                                                    \
+  void pushTo##Name(Name *vector, Type item) {                                      \
+    int capacity = vector->heapItems != NULL ? vector->capacity : inlineCount;      \
+    if (vector->count == capacity) reserve##Name(vector, capacity * 2);             \
+                                                                                    \
+    get##Name##Items(vector)[vector->count++] = item;                               \
+  }                                                                                 \
+                                                                                    \
+  Type popFrom##Name(Name *vector) {                                                \
+    if (vector->count == 0) return (Type){0};                                       \
+                                                                                    \
+    return get##Name##Items(vector)[--vector->count];                               \
+  }                                                                                 \
+                                                                                    \
+  Type getFrom##Name(Name *vector, int idx) {                                       \
+    if ((idx < 0) || (vector->count <= idx)) return (Type){0};                      \
+                                                                                    \
+    return get##Name##Items(vector)[idx];                                           \
+  }                                                                                 \
+                                                                                    \
+  void setTo##Name(Name *vector, int idx, Type item) {                              \
+    if ((idx < 0) || (vector->count <= idx)) return;                                \
+                                                                                    \
+    get##Name##Items(vector)[idx] = item;                                           \
+  }                                                                                 \
+                                                                                    \
+  void swapRemoveFrom##Name(Name *vector, int idx) {                                \
+    if ((idx < 0) || (vector->count <= idx)) return;                                \
+                                                                                    \
+    Type *items = get##Name##Items(vector);                                         \
+    items[idx] = items[--vector->count];                                            \
+  }                                                                                 \
+                                                                                    \
+  void destroy##Name(Name *vector) {                                                \
+    releaseMemory(vector->heapItems);                                               \
+    init##Name(vector);                                                             \
+  }
 
 typedef struct Scene Scene;
 
+typedef enum MemoryCategory {
+  MEMORY_SCENE,
+  MEMORY_OBJECTS,
+  MEMORY_TEXTURES,
+  MEMORY_FONTS,
+  MEMORY_FRAMES,
+  MEMORY_CATEGORY_COUNT
+} MemoryCategory;
+
+// reallocate follows realloc(): a NULL block allocates. Both receive the allocator's context.
+typedef struct RAAllocator {
+  void *context;
+  void *(*reallocate)(void *, void *, size_t);
+  void (*release)(void *, void *);
+} RAAllocator;
+
+typedef struct MemoryStats {
+  size_t current[MEMORY_CATEGORY_COUNT];
+  size_t peak[MEMORY_CATEGORY_COUNT];
+  size_t totalCurrent;
+  size_t totalPeak;
+} MemoryStats;
+
 typedef int FontIndex;
 typedef int TextureIndex;
+typedef uint64_t RAHash;
 
-Texture textures[255];
-unsigned char textureCount = 0;
+// width and height are the source image's size, which proxy textures keep for layout.
+typedef struct RATexture {
+  Texture levels[MAX_MIP_LEVELS];
+  int levelCount;
+  int width;
+  int height;
+} RATexture;
+
+extern RATexture textures[MAX_LOADED_ASSETS];
+extern unsigned char textureCount;
 
-Font fonts[255];
-unsigned char fontCount = 0;
+extern Font fonts[MAX_LOADED_ASSETS];
+extern bool sdfFonts[MAX_LOADED_ASSETS];
+extern unsigned char fontCount;
 
-typedef struct RAObject {
+typedef struct RAObject RAObject;
+typedef struct RAText RAText;
+
+struct RAObject {
   int _id;
   Vector2 position;
   Color color;
+  float opacity;
+  RAObject *parent;
+  // revision follows the bounds of the object's subtree, localRevision only its own geometry.
+  unsigned int revision;
+  unsigned int localRevision;
+  struct SpatialIndex *_index;
+  int _indexSlot;
 
   void (*render)(void *);
-} RAObject;
+  RAHash (*hash)(void *, RAHash);
+  Rectangle (*bounds)(void *);
+};
 
-typedef struct RAObjects {
-  RAObject **objects;
-  int count;
-  int capacity;
-} RAObjects;
+DECLARE_VECTOR(RAObjects, RAObject *, objects)
 
 typedef struct Animation {
   int _id;
   RAObject *object;
   float duration;
-  float elapsedTime;
+  double elapsedTime;
   bool done;
 
-  bool (*update)(void *, float);
+  bool (*update)(void *, double);
   void (*interpolate)(void *, float);
   void (*pushToObjects)(Scene *);
+  // Optional; called whenever the animation starts, so it can drop state from an earlier run.
+  void (*reset)(void *);
 } Animation;
 
-typedef struct Animations {
-  Animation **animations;
-  int count;
-  int capacity;
-} Animations;
+DECLARE_DEQUE(Animations, Animation *)
+
+typedef struct RATask {
+  void (*run)(void *, int, int);
+  void *context;
+  int start;
+  int end;
+  struct RATaskGroup *group;
+} RATask;
+
+DECLARE_DEQUE(RATasks, RATask)
+
+typedef struct RATaskGroup {
+  int pending;
+} RATaskGroup;
+
+typedef struct RATaskQueue {
+  pthread_mutex_t lock;
+  RATasks tasks;
+} RATaskQueue;
+
+typedef struct RAThreadPool {
+  int workerCount;
+  pthread_t *threads;
+  RATaskQueue *queues;
+  int *queueIds;
+  pthread_key_t queueKey;
+
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t done;
+  int queuedTasks;
+  bool stopping;
+} RAThreadPool;
+
+typedef enum FrameRingPolicy { FRAME_RING_DROP_OLDEST, FRAME_RING_BLOCK } FrameRingPolicy;
+
+// Shared memory layout: this header padded to FRAME_RING_ALIGN, then slotCount slots of
+// slotStride bytes. Each slot is an RAFrameSlot padded to FRAME_RING_ALIGN followed by
+// width * height RGBA8 pixels, top row first, with color premultiplied by alpha as the scene
+// blends it. A slot's sequence is 2n + 1 while ring frame n is being written
+// and 2n + 2 once it is complete.
+typedef struct RAFrameRingHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+  uint32_t slotCount;
+  uint32_t policy;
+  uint64_t slotStride;
+  uint64_t writeSequence;
+  uint64_t readSequence;
+} RAFrameRingHeader;
+
+typedef struct RAFrameSlot {
+  uint64_t sequence;
+  int64_t frame;
+  double time;
+} RAFrameSlot;
+
+typedef struct RAFrameRing {
+  char name[256];
+  int fd;
+  bool owner;
+  unsigned char *memory;
+  size_t size;
+  RAFrameRingHeader *header;
+} RAFrameRing;
+
+// Frame sequence files start with this header. Each frame follows as an RAFrameSequenceFrame,
+// one FrameSequenceTile per tile in row-major order, and the tile payloads. Keyframes store every
+// tile; other frames mark unchanged tiles as FRAME_TILE_SAME and store changed tiles XORed with
+// the previous frame. Payloads are raw or LZ4 blocks. The file ends with the keyframe index and
+// an RAFrameSequenceFooter.
+typedef struct RAFrameSequenceHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+  uint32_t tileSize;
+  uint32_t keyframeInterval;
+} RAFrameSequenceHeader;
+
+typedef struct RAFrameSequenceFrame {
+  uint64_t frame;
+  uint32_t keyframe;
+  uint32_t payloadSize;
+} RAFrameSequenceFrame;
+
+typedef enum FrameTileType { FRAME_TILE_SAME, FRAME_TILE_RAW, FRAME_TILE_LZ4 } FrameTileType;
+
+typedef struct FrameSequenceTile {
+  uint32_t type;
+  uint32_t size;
+} FrameSequenceTile;
+
+typedef struct FrameSequenceKeyframe {
+  uint64_t frame;
+  uint64_t offset;
+} FrameSequenceKeyframe;
+
+typedef struct RAFrameSequenceFooter {
+  uint64_t indexOffset;
+  uint64_t keyframeCount;
+  uint64_t frameCount;
+  uint32_t magic;
+  uint32_t version;
+} RAFrameSequenceFooter;
+
+DECLARE_VECTOR(FrameSequenceIndex, FrameSequenceKeyframe, keyframes)
+
+// A frame sequence file opened for writing or reading. pixels holds the last frame written or
+// read, which the next frame is a delta of. Frames keep the numbers they were written with,
+// which are consecutive from the first keyframe's.
+typedef struct RAFrameSequence {
+  FILE *file;
+  bool writing;
+  RAFrameSequenceHeader header;
+  int tilesX;
+  int tilesY;
+  long frameCount;
+  long currentFrame;
+  FrameSequenceIndex index;
+  unsigned char *pixels;
+  FrameSequenceTile *tiles;
+  size_t *tileOffsets;
+  unsigned char *payload;
+  size_t payloadCapacity;
+  uint64_t bytesWritten;
+} RAFrameSequence;
+
+// Seconds spent waiting for a free job slot and memory, building the scene, evaluating and
+// rendering it on the render thread, and in total until every frame was written.
+typedef struct RenderJobTiming {
+  double queued;
+  double setup;
+  double render;
+  double total;
+} RenderJobTiming;
+
+typedef struct RenderJob RenderJob;
+
+// A long-running process that renders scenes requested over a Unix socket. buildJob() turns a
+// request line into an initialised scene and returns the job's own data, which is passed to
+// releaseJob() after the scene has been recorded; it returns NULL to reject the request.
+typedef struct RARenderServer {
+  const char *socketPath;
+  int maxJobs;
+  size_t memoryBudget;
+  void *(*buildJob)(Scene *scene, const char *request, void *context);
+  void (*releaseJob)(void *job, void *context);
+  void *context;
+
+  int listenFd;
+  RenderJob *jobs;
+  bool stopping;
+} RARenderServer;
+
+DECLARE_SMALL_VECTOR(SpatialCell, int, SPATIAL_CELL_INLINE)
+
+// bounds are the object's when it was last filed. queued is set while the slot is on the index's
+// dirty list.
+typedef struct SpatialEntry {
+  RAObject *object;
+  unsigned int revision;
+  unsigned int order;
+  unsigned int stamp;
+  bool queued;
+  bool unbounded;
+  Rectangle bounds;
+  int minColumn;
+  int minRow;
+  int maxColumn;
+  int maxRow;
+} SpatialEntry;
+
+DECLARE_VECTOR(SpatialEntries, SpatialEntry, entries)
+DECLARE_VECTOR(SpatialSlots, int, slots)
+
+typedef struct SpatialIndex {
+  float cellSize;
+  int columns;
+  int rows;
+  SpatialCell *cells;
+  SpatialCell unbounded;
+  SpatialCell freeSlots;
+
+  SpatialEntries entries;
+  SpatialSlots dirtySlots;
+  unsigned int nextOrder;
+  unsigned int stamp;
+
+  SpatialSlots resultIds;
+  RAObjects results;
+} SpatialIndex;
+
+typedef enum DrawCommandType {
+  DRAW_TRIANGLES,
+  DRAW_RING,
+  DRAW_CIRCLE_SECTOR,
+  DRAW_TEXT,
+  DRAW_TEXTURE,
+  DRAW_PUSH_TRANSFORM,
+  DRAW_POP_TRANSFORM
+} DrawCommandType;
+
+// Colors are resolved and premultiplied. Triangles index the list's vertex arrays and text
+// indexes its character pool, so a command never points into scene objects. Rings and sectors
+// are tessellated into the vertex arrays as well and keep their parameters for sinks such as
+// SVG that draw arcs themselves.
+typedef struct DrawCommand {
+  DrawCommandType type;
+  Color color;
+
+  union {
+    struct {
+      int first;
+      int count;
+    } triangles;
+    struct {
+      Vector2 center;
+      float innerRadius;
+      float outerRadius;
+      float startAngle;
+      float endAngle;
+      int segments;
+      int first;
+      int count;
+    } ring;
+    struct {
+      FontIndex fontIdx;
+      int offset;
+      Vector2 position;
+      float fontSize;
+      float spacing;
+    } text;
+    struct {
+      TextureIndex textureIdx;
+      int level;
+      Vector2 position;
+      float scale;
+    } texture;
+    Matrix transform;
+  } params;
+} DrawCommand;
+
+DECLARE_VECTOR(DrawCommands, DrawCommand, commands)
+DECLARE_VECTOR(DrawVertices, Vector2, vertices)
+DECLARE_VECTOR(DrawColors, Color, colors)
+DECLARE_VECTOR(DrawChars, char, chars)
+
+typedef struct DisplayList {
+  DrawCommands commands;
+  DrawVertices vertices;
+  DrawColors colors;
+  DrawChars text;
+
+  Color background;
+  int width;
+  int height;
+  int replayed;
+} DisplayList;
+
+typedef enum TimingMode { TIMING_REALTIME, TIMING_FIXED_STEP } TimingMode;
+
+// One node of a compiled animation graph. Steps are stored in pre-order, so a node's subtree is
+// the contiguous range up to subtreeEnd. Driven steps are updated by the plan walk; the others
+// are containers or are updated by their parent.
+typedef struct PlanStep {
+  Animation *anim;
+  double start;
+  double end;
+  int parent;
+  int subtreeEnd;
+  bool driven;
+  // Set on entries whose driven steps write disjoint trees of objects and may run in parallel.
+  bool independent;
+} PlanStep;
+
+DECLARE_VECTOR(PlanSteps, PlanStep, steps)
+DECLARE_VECTOR(PlanEntries, int, entries)
+
+typedef struct ScenePlan {
+  PlanSteps steps;
+  PlanEntries entries;
+  int currentEntry;
+  double duration;
+} ScenePlan;
+
+// An extra output of recordScene(), downscaled from the frames rendered at the scene's size.
+// Only every frameInterval-th frame is written, e.g. for a thumbnail strip.
+typedef struct RARendition {
+  int width;
+  int height;
+  int frameInterval;
+  const char *outputDir;
+} RARendition;
+
+typedef struct GoldenResult {
+  bool passed;
+  int mismatchedPixels;
+  float maxDelta;
+  double renderTime;
+} GoldenResult;
 
 struct Scene {
   RAObjects objects;
+  SpatialIndex spatialIndex;
   Animations animations;
   Animation *currentAnimation;
+  double animationStartTime;
+
+  TimingMode timingMode;
+  int fps;
+  long frame;
+  double time;
+
   Color color;
   const char *title;
   int width;
   int height;
+  bool retireFadedObjects;
+
+  const char *outputDir;
+  const char *cacheDir;
+  RAFrameRing *frameRing;
+  RAFrameSequence *frameSequence;
+  RARendition renditions[MAX_RENDITIONS];
+  int renditionCount;
+
+  bool compiled;
+  ScenePlan plan;
+  bool showMemoryStats;
+  DisplayList displayList;
 };
 
-void initRAObjects(RAObjects *objects);
-void pushToRAObjects(RAObjects *objects, RAObject *newObj);
-RAObject *popFromRAObjects(RAObjects *objects);
-RAObject *getFromRAObjects(RAObjects *objects, int idx);
-void setToRAObjects(RAObjects *objects, int idx, RAObject *newObj);
+typedef enum TemplateParamType {
+  TEMPLATE_PARAM_TEXT,
+  TEMPLATE_PARAM_COLOR,
+  TEMPLATE_PARAM_FLOAT,
+  TEMPLATE_PARAM_VECTOR2
+} TemplateParamType;
+
+typedef union TemplateValue {
+  char *text;
+  Color color;
+  float number;
+  Vector2 vector;
+} TemplateValue;
+
+// A field of one of the template's objects that instances may override. Text parameters point
+// at an RAText's fullText and keep its reveal as long as the default text's, so the compiled
+// timing holds for any text.
+typedef struct TemplateParam {
+  const char *name;
+  TemplateParamType type;
+  RAObject *object;
+  void *field;
+  TemplateValue defaultValue;
+  float revealDuration;
+} TemplateParam;
+
+typedef struct TemplateOverride {
+  int param;
+  TemplateValue value;
+} TemplateOverride;
+
+// What fades and moves change on an object, restored before each instance plays.
+typedef struct TemplateObjectState {
+  RAObject *object;
+  Vector2 position;
+  Color color;
+  float opacity;
+} TemplateObjectState;
+
+DECLARE_VECTOR(TemplateParams, TemplateParam, params)
+DECLARE_VECTOR(TemplateOverrides, TemplateOverride, overrides)
+DECLARE_VECTOR(TemplateObjectStates, TemplateObjectState, states)
+
+// A scene whose objects, animations and compiled plan are built once and then only read by its
+// instances. Instances take turns on the template's scene: binding one rewinds the scene and
+// writes the instance's parameters into the objects. bound is set until the instance is
+// unbound, and only one instance may be bound at a time.
+typedef struct RASceneTemplate {
+  Scene scene;
+  TemplateParams params;
+  TemplateObjectStates states;
+  bool bound;
+} RASceneTemplate;
+
+// Holds only the parameters that differ from the template. Text values are not copied. Frame
+// files go to the instance's outputDir; renditions and frame sequences are the template's.
+typedef struct RASceneInstance {
+  RASceneTemplate *sceneTemplate;
+  TemplateOverrides overrides;
+  const char *outputDir;
+} RASceneInstance;
+
 int findIndexFromRAObjects(RAObjects *objects, RAObject *obj);
-void destroyRAObjects(RAObjects *objects);
-
-void initAnimations(Animations *anims);
-void pushToAnimations(Animations *anims, Animation *newAnim);
-Animation *popFromAnimations(Animations *anims);
-Animation *popFirstFromAnimations(Animations *anims);
-Animation *getFromAnimations(Animations *anims, int idx);
-void setToAnimations(Animations *anims, int idx, Animation *newAnim);
 bool containsInAnimations(Animations *anims, Animation *anim);
-void destroyAnimations(Animations *anims);
 
 void initRAObject(RAObject *obj, Vector2 position, Color color, void (*render)(void *));
 void initEmptyRAObject(RAObject *obj);
 void renderEmptyRAObject(void *self);
+RAHash hashBytes(RAHash hash, const void *data, size_t size);
+RAHash hashRAObjectBase(RAObject *obj, RAHash hash);
+RAHash hashDefaultRAObject(void *self, RAHash hash);
+Rectangle boundsDefaultRAObject(void *self);
+bool isBoundsUnbounded(Rectangle bounds);
+void markRAObjectDirty(RAObject *obj);
+RAObject *getRootRAObject(RAObject *obj);
+Vector2 getRAObjectWorldPosition(RAObject *obj);
+float getRAObjectOpacity(RAObject *obj);
+Color premultiplyColor(Color color, float opacity);
+Color resolveRAObjectColor(RAObject *obj, Color color);
 
 void initAnimation(Animation *anim,
                    RAObject *obj,
                    float duration,
-                   bool (*update)(void *, float),
+                   bool (*update)(void *, double),
                    void (*interpolate)(void *, float),
                    void (*pushToObjects)(Scene *));
 void initDefaultAnimation(Animation *anim,
                           RAObject *obj,
                           float duration,
                           void (*interpolate)(void *, float));
-bool updateDefaultAnimation(void *self, float dt);
+bool updateDefaultAnimation(void *self, double time);
 void pushToObjectsDefaultAnimation(Scene *scene);
 
 void initScene(Scene *scene, const char *title, int width, int height, Color color);
 void initDefaultScene(Scene *scene, const char *title);
+void initHeadlessScene(Scene *scene, const char *title, int width, int height, Color color);
+void addToScene(Scene *scene, RAObject *obj);
+RAObject *hitTestScene(Scene *scene, Vector2 point);
 void playAnimation(Scene *scene, Animation *anim);
 void playAnimations(Scene *scene, Animation **anims, int animCount);
+bool compileScene(Scene *scene);
+bool isRAObjectVisible(Scene *scene, RAObject *obj);
+void retireFadedObjects(Scene *scene);
 void renderScene(Scene *scene);
 void updateScene(Scene *scene, float dt);
+void seekScene(Scene *scene, double time);
+void stepScene(Scene *scene);
+void setSceneTimingMode(Scene *scene, TimingMode mode, int fps);
+void setSceneRecordOutput(Scene *scene, const char *outputDir, const char *cacheDir);
+void setSceneFrameRing(Scene *scene, RAFrameRing *ring);
+void setSceneFrameSequence(Scene *scene, RAFrameSequence *sequence);
+void addSceneRendition(
+    Scene *scene, int width, int height, int frameInterval, const char *outputDir);
+void downscaleImage(Image source, Image *target);
+RAHash hashSceneFrame(Scene *scene);
+Image captureSceneFrame(Scene *scene);
+Image captureSceneRegion(Scene *scene, Rectangle area);
+float comparePixels(Color a, Color b);
+GoldenResult compareImages(Image actual, Image expected, float tolerance);
+GoldenResult checkGoldenFrames(Scene *scene,
+                               const char *goldenDir,
+                               const char *name,
+                               const double *times,
+                               int timeCount,
+                               float tolerance,
+                               bool update);
 void destroyScene(Scene *scene);
 
+void setProxyPreview(float scale, const char *cacheDir);
+int getProxySegments(int segments);
 void startScene(Scene *scene);
 void recordScene(Scene *scene);
 
+// ----------------------------------------- Memory ------------------------------------------
+
+void setAllocator(RAAllocator allocator);
+void *allocateMemory(MemoryCategory category, size_t size);
+void *reallocateMemory(MemoryCategory category, void *block, size_t size);
+void releaseMemory(void *block);
+void trackMemory(MemoryCategory category, int64_t delta);
+MemoryStats getMemoryStats(void);
+const char *getMemoryCategoryName(MemoryCategory category);
+void drawMemoryStats(int x, int y);
+
+// --------------------------------------- Thread Pool ---------------------------------------
+
+void initThreadPool(RAThreadPool *pool, int workerCount);
+void submitTask(RAThreadPool *pool,
+                RATaskGroup *group,
+                void (*run)(void *, int, int),
+                void *context,
+                int start,
+                int end);
+void waitForTaskGroup(RAThreadPool *pool, RATaskGroup *group);
+void parallelFor(RAThreadPool *pool,
+                 int count,
+                 int chunkSize,
+                 void (*run)(void *, int, int),
+                 void *context);
+void destroyThreadPool(RAThreadPool *pool);
+void setSharedThreadPoolSize(int workerCount);
+RAThreadPool *getSharedThreadPool(void);
+void destroySharedThreadPool(void);
+
+// --------------------------------------- Frame Ring ----------------------------------------
+
+bool createFrameRing(RAFrameRing *ring,
+                     const char *name,
+                     int width,
+                     int height,
+                     int slotCount,
+                     FrameRingPolicy policy);
+bool openFrameRing(RAFrameRing *ring, const char *name);
+Image beginFrameRingWrite(RAFrameRing *ring);
+void endFrameRingWrite(RAFrameRing *ring, long frame, double time);
+const unsigned char *readFrameRing(RAFrameRing *ring, uint64_t sequence, RAFrameSlot *info);
+bool isFrameRingReadValid(RAFrameRing *ring, uint64_t sequence);
+void releaseFrameRing(RAFrameRing *ring, uint64_t sequence);
+void destroyFrameRing(RAFrameRing *ring);
+
+// ------------------------------------- Frame Sequence --------------------------------------
+
+bool createFrameSequence(
+    RAFrameSequence *sequence, const char *filename, int width, int height, int keyframeInterval);
+bool writeFrameSequence(RAFrameSequence *sequence, long frame, Image image);
+bool openFrameSequence(RAFrameSequence *sequence, const char *filename);
+bool readFrameSequence(RAFrameSequence *sequence, long frame, Image *target);
+bool closeFrameSequence(RAFrameSequence *sequence);
+int compressLz4Block(const unsigned char *source, int size, unsigned char *target);
+bool decompressLz4Block(const unsigned char *source,
+                        int size,
+                        unsigned char *target,
+                        int targetSize);
+
+// -------------------------------------- Render Server --------------------------------------
+
+void initRenderServer(RARenderServer *server,
+                      const char *socketPath,
+                      void *(*buildJob)(Scene *, const char *, void *),
+                      void (*releaseJob)(void *, void *),
+                      void *context);
+bool runRenderServer(RARenderServer *server);
+void stopRenderServer(RARenderServer *server);
+
+// -------------------------------------- Scene Template -------------------------------------
+
+void initSceneTemplate(
+    RASceneTemplate *sceneTemplate, const char *title, int width, int height, Color color);
+int addTemplateParam(RASceneTemplate *sceneTemplate,
+                     const char *name,
+                     TemplateParamType type,
+                     RAObject *object,
+                     void *field);
+int addTemplateTextParam(RASceneTemplate *sceneTemplate, const char *name, RAText *text);
+bool compileSceneTemplate(RASceneTemplate *sceneTemplate);
+void destroySceneTemplate(RASceneTemplate *sceneTemplate);
+void initSceneInstance(RASceneInstance *instance,
+                       RASceneTemplate *sceneTemplate,
+                       const char *outputDir);
+void setInstanceParam(RASceneInstance *instance, const char *name, TemplateValue value);
+void setInstanceText(RASceneInstance *instance, const char *name, char *text);
+void setInstanceColor(RASceneInstance *instance, const char *name, Color color);
+Scene *bindSceneInstance(RASceneInstance *instance);
+void unbindSceneInstance(RASceneInstance *instance);
+void recordSceneInstance(RASceneInstance *instance);
+void destroySceneInstance(RASceneInstance *instance);
+
+// -------------------------------------- Spatial Index --------------------------------------
+
+void initSpatialIndex(SpatialIndex *index, int width, int height, float cellSize);
+void insertIntoSpatialIndex(SpatialIndex *index, RAObject *obj);
+void removeFromSpatialIndex(SpatialIndex *index, RAObject *obj);
+void updateSpatialIndex(SpatialIndex *index);
+int querySpatialIndex(SpatialIndex *index, Rectangle area, RAObject ***results);
+int filterSpatialIndex(
+    SpatialIndex *index, RAObject **objects, int count, Rectangle area, RAObject ***results);
+void destroySpatialIndex(SpatialIndex *index);
+
+// ---------------------------------------- Batching -----------------------------------------
+
+void batchTriangle(Vector2 v1, Vector2 v2, Vector2 v3, Color color);
+void batchRectangle(Rectangle rect, Color color);
+void flushBatch(void);
+void destroyBatch(void);
+bool isBatchedRenderer(void (*render)(void *));
+void renderRAObject(RAObject *obj);
+
+// -------------------------------------- Display List ---------------------------------------
+
+void initDisplayList(DisplayList *list, int width, int height);
+void beginDisplayList(DisplayList *list, Color background);
+void endDisplayList(void);
+void emitTriangles(const Vector2 *vertices, const Color *colors, int vertexCount);
+void emitRing(Vector2 center,
+              float innerRadius,
+              float outerRadius,
+              float startAngle,
+              float endAngle,
+              int segments,
+              Color color);
+void emitCircleSector(
+    Vector2 center, float radius, float startAngle, float endAngle, int segments, Color color);
+void emitText(FontIndex fontIdx,
+              const char *text,
+              Vector2 position,
+              float fontSize,
+              float spacing,
+              Color color);
+void emitTexture(TextureIndex textureIdx, int level, Vector2 position, float scale, Color tint);
+void emitPushTransform(Matrix transform);
+void emitPopTransform(void);
+bool isDisplayListRenderer(void (*render)(void *));
+const char *getDrawCommandText(DisplayList *list, DrawCommand *command);
+void executeDisplayList(DisplayList *list,
+                        void (*execute)(void *, DisplayList *, DrawCommand *),
+                        void *context);
+void replayDisplayList(DisplayList *list);
+RAHash hashDisplayList(DisplayList *list);
+bool exportDisplayListSvg(DisplayList *list, const char *filename);
+void destroyDisplayList(DisplayList *list);
+
 // ------------------------------ Built-In RAObjects & Animations ------------------------------
 
 // --------------- RACircle ---------------
@@ -131,10 +1060,12 @@ void initDefaultCircle(RACircle *circle, Vector2 center, float radius);
 RACircle createCircle(Vector2 center, float radius);
 void renderDefaultCircle(void *self);
 void renderFillInnerCircle(void *self);
+RAHash hashDefaultCircle(void *self, RAHash hash);
+Rectangle boundsDefaultCircle(void *self);
 void initCircleAnimation(Animation *anim,
                          RACircle *circle,
                          float duration,
-                         bool (*update)(void *, float),
+                         bool (*update)(void *, double),
                          void (*interpolate)(void *, float));
 void initDefaultCircleAnimation(Animation *anim, RACircle *circle);
 Animation createCircleAnimation(RACircle *circle);
@@ -169,10 +1100,12 @@ void initDefaultRectangle(RARectangle *rect, Vector2 position, float width, floa
 RARectangle createRectangle(Vector2 position, float width, float height);
 void renderDefaultRectangle(void *self);
 void renderFillInnerRectangle(void *self);
+RAHash hashDefaultRectangle(void *self, RAHash hash);
+Rectangle boundsDefaultRectangle(void *self);
 void initRectangleAnimation(Animation *anim,
                             RARectangle *rect,
                             float duration,
-                            bool (*update)(void *, float),
+                            bool (*update)(void *, double),
                             void (*interpolate)(void *, float));
 void initDefaultRectangleAnimation(Animation *anim, RARectangle *rect);
 Animation createRectangleAnimation(RARectangle *rect);
@@ -207,7 +1140,7 @@ void interpolateDelayAnimation(void *self, float time);
 void initFadeOutAnimation(Animation *anim,
                           RAObject *obj,
                           float duration,
-                          bool (*update)(void *, float),
+                          bool (*update)(void *, double),
                           void (*interpolate)(void *, float));
 void initDefaultFadeOutAnimation(Animation *anim, RAObject *obj);
 Animation createFadeOutAnimation(RAObject *obj);
@@ -221,6 +1154,8 @@ typedef struct SyncAnimation {
   Animation base;
   Animation **animations;
   int animCount;
+  // Whether the children may be updated in parallel; -1 until the first update after a start.
+  int independent;
 } SyncAnimation;
 
 void initSyncAnimation(SyncAnimation *anim,
@@ -229,9 +1164,10 @@ void initSyncAnimation(SyncAnimation *anim,
                        void (*pushToObjects)(Scene *));
 void initDefaultSyncAnimation(SyncAnimation *anim, Animation **anims, int animCount);
 SyncAnimation createSyncAnimation(Animation **anims, int animCount);
-bool updateDefaultSyncAnimation(void *self, float dt);
+bool updateDefaultSyncAnimation(void *self, double time);
 void interpolateDefaultSyncAnimation(void *self, float time);
 void pushToObjectsDefaultSyncAnimation(Scene *scene);
+void resetDefaultSyncAnimation(void *self);
 
 // ----------------- Sync -----------------
 
@@ -248,19 +1184,19 @@ void initMoveAnimation(MoveAnimation *anim,
                        Animation *targetAnim,
                        float duration,
                        Vector2 targetPos,
-                       bool (*update)(void *, float),
+                       bool (*update)(void *, double),
                        void (*interpolate)(void *, float),
                        void (*pushToObjects)(Scene *));
 void initDefaultMoveAnimation(MoveAnimation *anim, Animation *targetAnim, Vector2 targetPos);
 MoveAnimation createMoveAnimation(Animation *targetAnim, Vector2 targetPos);
-bool updateDefaultMoveAnimation(void *self, float dt);
+bool updateDefaultMoveAnimation(void *self, double time);
 void pushToObjectsDefaultMoveAnimation(Scene *scene);
 
 // ----------------- Move -----------------
 
 // ---------------- RAText ----------------
 
-typedef struct RAText {
+struct RAText {
   RAObject base;
   FontIndex fontIdx;
   float spacing;
@@ -268,7 +1204,7 @@ typedef struct RAText {
   char *fullText;
   float charRevealTime;
   size_t displayCharCount;
-} RAText;
+};
 
 void initText(RAText *text,
               char *fullText,
@@ -282,13 +1218,17 @@ void initText(RAText *text,
 void initDefaultText(RAText *text, char *fullText, Vector2 pos);
 RAText createText(char *fullText, Vector2 pos);
 void renderDefaultText(void *self);
+RAHash hashDefaultText(void *self, RAHash hash);
+Rectangle boundsDefaultText(void *self);
 void setFontForText(RAText *text, char *filename);
 void setFontForTextEx(
     RAText *text, char *filename, int fontSize, int *codepoints, int codepointCount);
+FontIndex loadSdfFont(const char *filename, int *codepoints, int codepointCount);
+void setSdfFontForText(RAText *text, char *filename);
 void initTextAnimation(Animation *anim,
                        RAText *text,
                        float duration,
-                       bool (*update)(void *, float),
+                       bool (*update)(void *, double),
                        void (*interpolate)(void *, float));
 void initDefaultTextAnimation(Animation *anim, RAText *text);
 Animation createTextAnimation(RAText *text);
@@ -310,10 +1250,14 @@ void initImage(
 void initDefaultImage(RAImage *image, char *filename, Vector2 pos);
 RAImage createImage(char *filename, Vector2 pos);
 void renderDefaultImage(void *self);
+TextureIndex loadTextureWithMipmaps(Image source);
+int selectTextureLevel(RATexture *texture, float scale);
+RAHash hashDefaultImage(void *self, RAHash hash);
+Rectangle boundsDefaultImage(void *self);
 void initImageAnimation(Animation *anim,
                         RAImage *image,
                         float duration,
-                        bool (*update)(void *, float),
+                        bool (*update)(void *, double),
                         void (*interpolate)(void *, float));
 void initDefaultImageAnimation(Animation *anim, RAImage *image);
 Animation createImageAnimation(RAImage *image);
@@ -321,4 +1265,202 @@ void interpolateDefaultImageAnimation(void *self, float time);
 
 // --------------- RAImage ----------------
 
+// --------------- RAGroup ----------------
+
+typedef struct RAGroup {
+  RAObject base;
+  RAObjects children;
+  float rotation;
+  Vector2 scale;
+
+  Matrix localTransform;
+  Matrix worldTransform;
+  unsigned int version;
+  unsigned int parentVersion;
+  unsigned int transformRevision;
+} RAGroup;
+
+void initGroup(
+    RAGroup *group, Vector2 position, float rotation, Vector2 scale, void (*render)(void *));
+void initDefaultGroup(RAGroup *group, Vector2 position);
+RAGroup createGroup(Vector2 position);
+void addToGroup(RAGroup *group, RAObject *obj);
+void updateGroupTransform(RAGroup *group);
+void renderDefaultGroup(void *self);
+RAHash hashDefaultGroup(void *self, RAHash hash);
+Rectangle boundsDefaultGroup(void *self);
+void destroyGroup(RAGroup *group);
+void initGroupAnimation(Animation *anim,
+                        RAGroup *group,
+                        float duration,
+                        bool (*update)(void *, double),
+                        void (*interpolate)(void *, float));
+void initDefaultGroupAnimation(Animation *anim, RAGroup *group);
+Animation createGroupAnimation(RAGroup *group);
+void interpolateDefaultGroupAnimation(void *self, float time);
+
+// --------------- RAGroup ----------------
+
+// ------------- RAParticles --------------
+
+typedef struct RAParticles {
+  RAObject base;
+  int capacity;
+  int count;
+  float *x;
+  float *y;
+  float *vx;
+  float *vy;
+  float *life;
+  Color *colors;
+
+  float emissionRate;
+  float lifetime;
+  float speed;
+  float size;
+  Vector2 gravity;
+
+  uint32_t seed;
+  double lastTime;
+  double emissionAccumulator;
+  Rectangle extent;
+} RAParticles;
+
+void initParticles(RAParticles *particles,
+                   Vector2 emitter,
+                   int capacity,
+                   float emissionRate,
+                   float lifetime,
+                   float speed,
+                   float size,
+                   Color color,
+                   void (*render)(void *));
+void initDefaultParticles(RAParticles *particles, Vector2 emitter, int capacity);
+RAParticles createParticles(Vector2 emitter, int capacity);
+void resetParticles(RAParticles *particles);
+void stepParticles(RAParticles *particles, double time, bool emit);
+void renderDefaultParticles(void *self);
+RAHash hashDefaultParticles(void *self, RAHash hash);
+Rectangle boundsDefaultParticles(void *self);
+void destroyParticles(RAParticles *particles);
+void initParticlesAnimation(Animation *anim,
+                            RAParticles *particles,
+                            float duration,
+                            bool (*update)(void *, double),
+                            void (*interpolate)(void *, float));
+void initDefaultParticlesAnimation(Animation *anim, RAParticles *particles);
+Animation createParticlesAnimation(RAParticles *particles);
+void interpolateDefaultParticlesAnimation(void *self, float time);
+void resetDefaultParticlesAnimation(void *self);
+
+// ------------- RAParticles --------------
+
+// ---------------- RAPath ----------------
+
+// A flattened point with the arc length up to it; a pen-up point starts a new subpath.
+typedef struct PathPoint {
+  Vector2 position;
+  float length;
+  bool penDown;
+} PathPoint;
+
+DECLARE_VECTOR(PathPoints, PathPoint, points)
+DECLARE_VECTOR(PathVertices, Vector2, vertices)
+DECLARE_VECTOR(PathOffsets, int, offsets)
+
+typedef struct RAPath {
+  RAObject base;
+  PathPoints points;
+  RAHash geometryHash;
+  Rectangle extent;
+
+  float thickness;
+  float reveal;
+
+  PathVertices strokeVertices;
+  PathOffsets strokeOffsets;
+  float strokeThickness;
+} RAPath;
+
+void initPath(
+    RAPath *path, Vector2 position, float thickness, Color color, void (*render)(void *));
+void initDefaultPath(RAPath *path, Vector2 position);
+RAPath createPath(Vector2 position);
+void pathMoveTo(RAPath *path, Vector2 point);
+void pathLineTo(RAPath *path, Vector2 point);
+void pathQuadraticTo(RAPath *path, Vector2 control, Vector2 end);
+void pathCubicTo(RAPath *path, Vector2 control1, Vector2 control2, Vector2 end);
+float getPathLength(RAPath *path);
+void renderDefaultPath(void *self);
+RAHash hashDefaultPath(void *self, RAHash hash);
+Rectangle boundsDefaultPath(void *self);
+void destroyPath(RAPath *path);
+void initPathAnimation(Animation *anim,
+                       RAPath *path,
+                       float duration,
+                       bool (*update)(void *, double),
+                       void (*interpolate)(void *, float));
+void initDefaultPathAnimation(Animation *anim, RAPath *path);
+Animation createPathAnimation(RAPath *path);
+void interpolateDefaultPathAnimation(void *self, float time);
+
+// ---------------- RAPath ----------------
+
+// ---------------- RAMorph ---------------
+
+// Morphs between the outlines of two circles or rectangles. Both outlines are resampled to
+// pointCount points and matched when the morph starts; the stored points are the start outline
+// and the offsets to the end outline, so each frame only evaluates points = from + delta * t.
+// Only the first outlineSegments edges are stroked, so partly drawn shapes stay open.
+typedef struct RAMorph {
+  RAObject base;
+  RAObject *from;
+  RAObject *to;
+  int pointCount;
+  bool prepared;
+  float progress;
+  int fromSegments;
+  int toSegments;
+  int outlineSegments;
+
+  float *fromX;
+  float *fromY;
+  float *deltaX;
+  float *deltaY;
+  float *x;
+  float *y;
+
+  float fromThickness;
+  float toThickness;
+  float thickness;
+  Color fromOutlineColor;
+  Color toOutlineColor;
+  Color outlineColor;
+  Color fromFillColor;
+  Color toFillColor;
+} RAMorph;
+
+void initMorph(
+    RAMorph *morph, RAObject *from, RAObject *to, int pointCount, void (*render)(void *));
+void initDefaultMorph(RAMorph *morph, RAObject *from, RAObject *to);
+RAMorph createMorph(RAObject *from, RAObject *to);
+bool sampleShapeOutline(RAObject *obj, int pointCount, float *x, float *y, int *segments);
+void prepareMorph(RAMorph *morph);
+void setMorphProgress(RAMorph *morph, float progress);
+void renderDefaultMorph(void *self);
+RAHash hashDefaultMorph(void *self, RAHash hash);
+Rectangle boundsDefaultMorph(void *self);
+void destroyMorph(RAMorph *morph);
+void initMorphAnimation(Animation *anim,
+                        RAMorph *morph,
+                        float duration,
+                        bool (*update)(void *, double),
+                        void (*interpolate)(void *, float));
+void initDefaultMorphAnimation(Animation *anim, RAMorph *morph);
+Animation createMorphAnimation(RAMorph *morph);
+void interpolateDefaultMorphAnimation(void *self, float time);
+void resetDefaultMorphAnimation(void *self);
+
+// ---------------- RAMorph ---------------
+
 #endif  // RAYANIM_H
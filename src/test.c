@@ -33,7 +33,7 @@ int main(void) {
   MoveAnimation rect1Move = createMoveAnimation(&rect1Anim, (Vector2){200, 600});
 
   RAText text1 = createText("Hello, this is rayanim!", (Vector2){800, 800});
-  setFontForTextEx(&text1, "Iosevka-Bold.ttf", 255, NULL, 0);
+  setSdfFontForText(&text1, "Iosevka-Bold.ttf");
   Animation text1Anim = createTextAnimation(&text1);
 
   RAImage image1 = createImage("/home/nobu/Downloads/bach-fun.png", (Vector2){100, 100});
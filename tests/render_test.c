@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rayanim.h"
+#include "raylib.h"
+
+#define TEST_WIDTH 320
+#define TEST_HEIGHT 240
+#define TEST_TOLERANCE 0.02f
+#define TEST_IMAGE "render_test_checker.png"
+
+// Every case renders one primitive or animation headlessly and compares the frames at its
+// times against tests/goldens/<name>_N.png. Run with --update to rewrite the goldens.
+typedef struct RenderCase {
+  const char *name;
+  void (*build)(Scene *);
+  void (*release)(void);
+  double times[4];
+} RenderCase;
+
+static void buildCircles(Scene *scene) {
+  static RACircle outline;
+  static RACircle filled;
+  static Animation outlineAnim;
+  static Animation filledAnim;
+  static Animation *anims[2];
+  static SyncAnimation sync;
+
+  outline = createCircle((Vector2){90, 120}, 60);
+  outline.outlineThickness = 12.0f;
+  outline.outlineColor = DARKGRAY;
+  outlineAnim = createCircleAnimation(&outline);
+  outlineAnim.duration = 1.0f;
+
+  filled = createCircle((Vector2){230, 120}, 50);
+  filled.base.color = SKYBLUE;
+  filled.outlineThickness = 8.0f;
+  filled.base.render = renderFillInnerCircle;
+  filledAnim = createCircleAnimation(&filled);
+  filledAnim.duration = 1.0f;
+
+  anims[0] = &outlineAnim;
+  anims[1] = &filledAnim;
+  sync = createSyncAnimation(anims, 2);
+  playAnimation(scene, (Animation *)&sync);
+}
+
+static void buildRectangles(Scene *scene) {
+  static RARectangle rect;
+  static RARectangle square;
+  static Animation rectAnim;
+  static Animation squareAnim;
+
+  rect = createRectangle((Vector2){20, 30}, 160, 90);
+  rect.outlineThickness = 6.0f;
+  rect.base.render = renderFillInnerRectangle;
+  rectAnim = createRectangleAnimation(&rect);
+  rectAnim.duration = 0.8f;
+
+  square = createSquare((Vector2){200, 120}, 90);
+  square.outlineThickness = 10.0f;
+  square.outlineColor = MAROON;
+  squareAnim = createRectangleAnimation(&square);
+  squareAnim.duration = 0.8f;
+
+  playAnimation(scene, &rectAnim);
+  playAnimation(scene, &squareAnim);
+}
+
+static void buildText(Scene *scene) {
+  static RAText text;
+  static Animation textAnim;
+
+  text = createText("rayanim", (Vector2){20, 90});
+  text.fontSize = 40;
+  text.spacing = 4.0f;
+  textAnim = createTextAnimation(&text);
+
+  playAnimation(scene, &textAnim);
+}
+
+static void buildImage(Scene *scene) {
+  static RAImage image;
+  static Animation imageAnim;
+  static Animation fadeOut;
+
+  Image checker = GenImageChecked(64, 64, 8, 8, ORANGE, DARKBLUE);
+  ExportImage(checker, TEST_IMAGE);
+  UnloadImage(checker);
+
+  image = createImage(TEST_IMAGE, (Vector2){40, 40});
+  image.scale = 2.0f;
+  imageAnim = createImageAnimation(&image);
+  fadeOut = createFadeOutAnimation((RAObject *)&image);
+
+  playAnimation(scene, &imageAnim);
+  playAnimation(scene, &fadeOut);
+}
+
+static void buildMove(Scene *scene) {
+  static RACircle circle;
+  static Animation circleAnim;
+  static MoveAnimation move;
+  static Animation delay;
+
+  circle = createCircle((Vector2){50, 50}, 30);
+  circle.outlineThickness = 8.0f;
+  circleAnim = createCircleAnimation(&circle);
+  circleAnim.duration = 0.5f;
+  move = createMoveAnimation(&circleAnim, (Vector2){260, 180});
+  delay = createDelayAnimation(0.5f);
+
+  playAnimation(scene, &delay);
+  playAnimation(scene, (Animation *)&move);
+}
+
+static RAGroup group;
+
+static void buildGroup(Scene *scene) {
+  static RACircle circle;
+  static RARectangle rect;
+  static Animation groupAnim;
+
+  group = createGroup((Vector2){160, 120});
+  group.rotation = 30.0f;
+  group.scale = (Vector2){1.5f, 1.0f};
+
+  circle = createCircle((Vector2){-40, 0}, 25);
+  circle.outlineThickness = 6.0f;
+  rect = createSquare((Vector2){10, -25}, 50);
+  rect.outlineThickness = 6.0f;
+  addToGroup(&group, &circle.base);
+  addToGroup(&group, &rect.base);
+
+  groupAnim = createGroupAnimation(&group);
+  playAnimation(scene, &groupAnim);
+}
+
+static void releaseGroup(void) {
+  destroyGroup(&group);
+}
+
+static RAParticles particles;
+
+static void buildParticles(Scene *scene) {
+  static Animation particlesAnim;
+
+  particles = createParticles((Vector2){160, 200}, 256);
+  particles.gravity = (Vector2){0, 60};
+  particlesAnim = createParticlesAnimation(&particles);
+  particlesAnim.duration = 2.0f;
+
+  playAnimation(scene, &particlesAnim);
+}
+
+static void releaseParticles(void) {
+  destroyParticles(&particles);
+}
+
+static RAPath path;
+
+static void buildPath(Scene *scene) {
+  static Animation pathAnim;
+
+  path = createPath((Vector2){20, 20});
+  path.thickness = 6.0f;
+  pathMoveTo(&path, (Vector2){0, 180});
+  pathLineTo(&path, (Vector2){80, 40});
+  pathQuadraticTo(&path, (Vector2){140, -20}, (Vector2){180, 120});
+  pathCubicTo(&path, (Vector2){220, 220}, (Vector2){260, 0}, (Vector2){280, 150});
+  pathAnim = createPathAnimation(&path);
+  pathAnim.duration = 1.5f;
+
+  playAnimation(scene, &pathAnim);
+}
+
+static void releasePath(void) {
+  destroyPath(&path);
+}
+
+static RAMorph morph;
+
+static void buildMorph(Scene *scene) {
+  static RACircle circle;
+  static RARectangle rect;
+  static Animation morphAnim;
+
+  // A morph starts from what is drawn, so both shapes are shown complete.
+  circle = createCircle((Vector2){160, 120}, 70);
+  circle.outlineThickness = 8.0f;
+  circle.angle = 360.0f;
+  rect = createRectangle((Vector2){70, 60}, 180, 120);
+  rect.outlineThickness = 8.0f;
+  rect.firstQuarter = rect.secondQuarter = rect.thirdQuarter = rect.lastQuarter = 1.0f;
+  rect.base.color = GOLD;
+  rect.base.render = renderFillInnerRectangle;
+
+  morph = createMorph(&circle.base, &rect.base);
+  morphAnim = createMorphAnimation(&morph);
+  morphAnim.duration = 1.0f;
+
+  playAnimation(scene, &morphAnim);
+}
+
+static void releaseMorph(void) {
+  destroyMorph(&morph);
+}
+
+static const RenderCase cases[] = {
+    {"circles", buildCircles, NULL, {0.25, 0.5, 0.75, 1.5}},
+    {"rectangles", buildRectangles, NULL, {0.2, 0.6, 1.0, 1.8}},
+    {"text", buildText, NULL, {0.05, 0.1, 0.15, 0.5}},
+    {"image", buildImage, NULL, {0.1, 0.5, 1.0, 1.4}},
+    {"move", buildMove, NULL, {0.25, 0.75, 1.0, 1.2}},
+    {"group", buildGroup, releaseGroup, {0.1, 0.4, 0.8, 1.0}},
+    {"particles", buildParticles, releaseParticles, {0.25, 0.5, 1.0, 1.9}},
+    {"path", buildPath, releasePath, {0.3, 0.75, 1.2, 1.6}},
+    {"morph", buildMorph, releaseMorph, {0.0, 0.3, 0.6, 1.0}},
+};
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s GOLDEN_DIR [--update]\n", argv[0]);
+    return 2;
+  }
+
+  const char *goldenDir = argv[1];
+  bool update = ((argc > 2) && (strcmp(argv[2], "--update") == 0)) ||
+                (getenv("RAYANIM_UPDATE_GOLDENS") != NULL);
+  int caseCount = sizeof(cases) / sizeof(cases[0]);
+  int failed = 0;
+
+  SetTraceLogLevel(LOG_WARNING);
+
+  for (int i = 0; i < caseCount; i++) {
+    Scene scene;
+    initHeadlessScene(&scene, "rayanim render test", TEST_WIDTH, TEST_HEIGHT, RAYWHITE);
+    cases[i].build(&scene);
+
+    GoldenResult result = checkGoldenFrames(
+        &scene, goldenDir, cases[i].name, cases[i].times, 4, TEST_TOLERANCE, update);
+    printf("%-12s %-6s %8.2f ms\n",
+           cases[i].name,
+           result.passed ? "ok" : "FAILED",
+           result.renderTime * 1000.0);
+    if (!result.passed) failed++;
+
+    destroyScene(&scene);
+    if (cases[i].release != NULL) cases[i].release();
+  }
+
+  CloseWindow();
+
+  printf("%d of %d cases failed\n", failed, caseCount);
+  return failed > 0 ? 1 : 0;
+}